@@ -0,0 +1,347 @@
+/*
+  ==============================================================================
+
+    Offline metering of audio files, spread over all cores.
+
+    BatchAnalyser [--json file] [--csv file] [--threads n] files or folders...
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+namespace
+{
+    constexpr int blockSize = 4096;
+    constexpr float truePeakLimitDbtp = -1.0f;
+    constexpr double correlationTimeConstantMs = 300.0;
+
+    struct FileSummary
+    {
+        juce::File file;
+        juce::String error;
+
+        double sampleRate{ 0.0 };
+        int numChannels{ 0 };
+        double lengthSeconds{ 0.0 };
+
+        float samplePeakDb{ 0.0f };
+        float truePeakDbtp{ 0.0f };
+        int truePeakOvers{ 0 };
+        int clipCount{ 0 };
+        float rmsDb{ 0.0f };        // loudest channel
+
+        // first channel pair, 0 for mono
+        float correlation{ 0.0f };
+        float minCorrelation{ 0.0f };
+
+        LoudnessEngine::Values loudness;
+        float maxMomentary{ -std::numeric_limits<float>::infinity() };
+        float maxShortTerm{ -std::numeric_limits<float>::infinity() };
+    };
+
+    float toDb(double gain)
+    {
+        return juce::Decibels::gainToDecibels(static_cast<float>(gain), -std::numeric_limits<float>::infinity());
+    }
+
+    FileSummary analyseFile(const juce::File& file)
+    {
+        FileSummary summary;
+        summary.file = file;
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+        if (reader == nullptr)
+        {
+            summary.error = "unreadable";
+            return summary;
+        }
+
+        auto numChannels = static_cast<int>(reader->numChannels);
+        summary.sampleRate = reader->sampleRate;
+        summary.numChannels = numChannels;
+        summary.lengthSeconds = reader->lengthInSamples / reader->sampleRate;
+
+        auto layout = reader->getChannelLayout();
+        if (layout.size() != numChannels)
+            layout = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+        // the same engines the plugin runs on its audio thread
+        LoudnessEngine loudnessEngine;
+        loudnessEngine.prepare(reader->sampleRate, layout);
+
+        TruePeakDetector truePeakDetector;
+        truePeakDetector.prepare(numChannels);
+        auto overLevel = juce::Decibels::decibelsToGain(truePeakLimitDbtp);
+
+        CorrelationEngine correlationEngine;
+        correlationEngine.prepare(reader->sampleRate, correlationTimeConstantMs);
+        std::vector<float> unitWeights(blockSize, 1.0f);
+        WeightedProducts products;
+        summary.minCorrelation = 1.0f;
+
+        std::vector<ChannelStats> stats(numChannels);
+        std::vector<double> sumsOfSquares(numChannels, 0.0);
+        float samplePeak = 0.0f, truePeak = 0.0f;
+
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+
+        for (juce::int64 position = 0; position < reader->lengthInSamples; position += blockSize)
+        {
+            auto num = static_cast<int>(juce::jmin<juce::int64>(blockSize, reader->lengthInSamples - position));
+            if (!reader->read(&buffer, 0, num, position, true, true))
+            {
+                summary.error = "read failed";
+                return summary;
+            }
+
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, num);
+
+            MeterKernels::analyse(block.getArrayOfReadPointers(), numChannels, num, stats.data());
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                samplePeak = juce::jmax(samplePeak, stats[channel].absMax);
+                sumsOfSquares[channel] += stats[channel].sumOfSquares;
+                summary.clipCount += stats[channel].clipCount;
+
+                auto channelTruePeak = truePeakDetector.process(channel, block.getReadPointer(channel), num, overLevel);
+                truePeak = juce::jmax(truePeak, channelTruePeak.peak);
+                summary.truePeakOvers += channelTruePeak.numOvers;
+            }
+
+            if (numChannels > 1)
+            {
+                auto* left = block.getReadPointer(0);
+                auto* right = block.getReadPointer(1);
+
+                auto blockProducts = MeterKernels::weightedProducts(unitWeights.data(), left, right, num);
+                products.leftRight += blockProducts.leftRight;
+                products.leftLeft += blockProducts.leftLeft;
+                products.rightRight += blockProducts.rightRight;
+
+                correlationEngine.process(left, right, num);
+                summary.minCorrelation = juce::jmin(summary.minCorrelation, correlationEngine.getCorrelation());
+            }
+
+            loudnessEngine.process(block);
+            auto loudness = loudnessEngine.getValues();
+            summary.maxMomentary = juce::jmax(summary.maxMomentary, loudness.momentary);
+            summary.maxShortTerm = juce::jmax(summary.maxShortTerm, loudness.shortTerm);
+        }
+
+        summary.samplePeakDb = toDb(samplePeak);
+        summary.truePeakDbtp = toDb(truePeak);
+        summary.loudness = loudnessEngine.getValues();
+
+        double loudestMeanSquare = 0.0;
+        for (auto sum : sumsOfSquares)
+            loudestMeanSquare = juce::jmax(loudestMeanSquare, sum / juce::jmax<juce::int64>(1, reader->lengthInSamples));
+        summary.rmsDb = toDb(std::sqrt(loudestMeanSquare));
+
+        if (numChannels > 1)
+        {
+            auto denominator = std::sqrt(products.leftLeft * products.rightRight);
+            summary.correlation = denominator > 0.0 ? static_cast<float>(products.leftRight / denominator) : 0.0f;
+        }
+        else
+        {
+            summary.minCorrelation = 0.0f;
+        }
+
+        return summary;
+    }
+
+    //==============================================================================
+    // JSON has no infinity, silence is written as null
+    juce::var toVar(float value)
+    {
+        return std::isfinite(value) ? juce::var(value) : juce::var();
+    }
+
+    juce::String toJson(const std::vector<FileSummary>& summaries)
+    {
+        juce::Array<juce::var> files;
+
+        for (auto& summary : summaries)
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty("file", summary.file.getFullPathName());
+
+            if (summary.error.isNotEmpty())
+            {
+                object->setProperty("error", summary.error);
+            }
+            else
+            {
+                object->setProperty("sampleRate", summary.sampleRate);
+                object->setProperty("channels", summary.numChannels);
+                object->setProperty("lengthSeconds", summary.lengthSeconds);
+                object->setProperty("samplePeakDb", toVar(summary.samplePeakDb));
+                object->setProperty("truePeakDbtp", toVar(summary.truePeakDbtp));
+                object->setProperty("truePeakOvers", summary.truePeakOvers);
+                object->setProperty("clippedSamples", summary.clipCount);
+                object->setProperty("rmsDb", toVar(summary.rmsDb));
+                object->setProperty("correlation", summary.correlation);
+                object->setProperty("minCorrelation", summary.minCorrelation);
+                object->setProperty("integratedLufs", toVar(summary.loudness.integrated));
+                object->setProperty("loudnessRangeLu", summary.loudness.range);
+                object->setProperty("maxMomentaryLufs", toVar(summary.maxMomentary));
+                object->setProperty("maxShortTermLufs", toVar(summary.maxShortTerm));
+            }
+
+            files.add(juce::var(object));
+        }
+
+        return juce::JSON::toString(juce::var(files));
+    }
+
+    /** RFC 4180: every field quoted, embedded quotes doubled. */
+    juce::String csvField(const juce::String& text)
+    {
+        return "\"" + text.replace("\"", "\"\"") + "\"";
+    }
+
+    juce::String toCsv(const std::vector<FileSummary>& summaries)
+    {
+        auto number = [](float value) { return std::isfinite(value) ? juce::String(value, 2) : juce::String(); };
+
+        juce::StringArray lines;
+        lines.add("file,error,sample_rate,channels,length_s,sample_peak_db,true_peak_dbtp,true_peak_overs,"
+                  "clipped_samples,rms_db,correlation,min_correlation,integrated_lufs,lra_lu,"
+                  "max_momentary_lufs,max_short_term_lufs");
+
+        for (auto& summary : summaries)
+        {
+            juce::StringArray fields;
+            fields.add(csvField(summary.file.getFullPathName()));
+            fields.add(csvField(summary.error));
+
+            if (summary.error.isEmpty())
+            {
+                fields.add(juce::String(summary.sampleRate));
+                fields.add(juce::String(summary.numChannels));
+                fields.add(juce::String(summary.lengthSeconds, 3));
+                fields.add(number(summary.samplePeakDb));
+                fields.add(number(summary.truePeakDbtp));
+                fields.add(juce::String(summary.truePeakOvers));
+                fields.add(juce::String(summary.clipCount));
+                fields.add(number(summary.rmsDb));
+                fields.add(number(summary.correlation));
+                fields.add(number(summary.minCorrelation));
+                fields.add(number(summary.loudness.integrated));
+                fields.add(number(summary.loudness.range));
+                fields.add(number(summary.maxMomentary));
+                fields.add(number(summary.maxShortTerm));
+            }
+
+            lines.add(fields.joinIntoString(","));
+        }
+
+        return lines.joinIntoString("\n") + "\n";
+    }
+
+    //==============================================================================
+    juce::Array<juce::File> collectFiles(const juce::StringArray& paths)
+    {
+        juce::Array<juce::File> files;
+
+        // folders are scanned for everything analyseFile() can read
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        auto wildcard = formats.getWildcardForAllFormats();
+
+        for (auto& path : paths)
+        {
+            auto file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+
+            if (file.isDirectory())
+                files.addArray(file.findChildFiles(juce::File::findFiles, true, wildcard));
+            else if (file.existsAsFile())
+                files.add(file);
+            else
+                std::cerr << "skipping " << path << ": not found\n";
+        }
+
+        return files;
+    }
+
+    void printUsage()
+    {
+        std::cout << "usage: BatchAnalyser [--json file] [--csv file] [--threads n] files or folders...\n";
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::File jsonFile, csvFile;
+    int numThreads = juce::SystemStats::getNumCpus();
+    juce::StringArray paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String argument(argv[i]);
+        auto hasValue = i + 1 < argc;
+
+        if (argument == "--json" && hasValue)
+            jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (argument == "--csv" && hasValue)
+            csvFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (argument == "--threads" && hasValue)
+            numThreads = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+        else if (argument.startsWith("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            paths.add(argument);
+    }
+
+    auto files = collectFiles(paths);
+    if (files.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<FileSummary> summaries(files.size());
+    auto start = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        WorkStealingPool pool(numThreads);
+
+        // each job writes only its own slot
+        for (int i = 0; i < files.size(); ++i)
+            pool.submit([&summaries, &files, i] { summaries[i] = analyseFile(files[i]); });
+
+        pool.waitForAll();
+    }
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    double audioSeconds = 0.0;
+    int numFailed = 0;
+    for (auto& summary : summaries)
+    {
+        audioSeconds += summary.lengthSeconds;
+        numFailed += summary.error.isNotEmpty() ? 1 : 0;
+    }
+
+    std::cout << files.size() << " files, " << numFailed << " failed, " << juce::String(audioSeconds, 1)
+              << " s of audio in " << juce::String(seconds, 2) << " s ("
+              << juce::String(audioSeconds / juce::jmax(seconds, 0.001), 0) << "x real time)\n";
+
+    if (jsonFile != juce::File() && !jsonFile.replaceWithText(toJson(summaries)))
+        std::cerr << "could not write " << jsonFile.getFullPathName() << "\n";
+
+    if (csvFile != juce::File() && !csvFile.replaceWithText(toCsv(summaries)))
+        std::cerr << "could not write " << csvFile.getFullPathName() << "\n";
+
+    if (jsonFile == juce::File() && csvFile == juce::File())
+        std::cout << toCsv(summaries);
+
+    return numFailed > 0 ? 2 : 0;
+}
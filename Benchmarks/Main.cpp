@@ -0,0 +1,590 @@
+/*
+  ==============================================================================
+
+    Benchmarks for the metering hot paths: the kernels, processBlock, the
+    FIFOs and the spectrum on the analysis side, the meter components and the
+    editor frame on the GUI side. Every result is printed as a table row and can be written out
+    with --csv and --json for comparison between builds.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/PluginEditor.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    const std::array<int, 4> channelCounts{ 1, 2, 6, MAX_CHANNELS };
+
+    // keeps the optimiser from dropping the measured work
+    volatile double sink = 0.0;
+
+    struct Result
+    {
+        juce::String name;
+        int channels{ 0 };
+        int blockSize{ 0 };
+        int width{ 0 }, height{ 0 };
+        double value{ 0.0 };
+        juce::String unit;
+    };
+
+    std::vector<Result> results;
+
+    void report(const Result& result)
+    {
+        results.push_back(result);
+
+        std::cout << result.name.paddedRight(' ', 28)
+                  << juce::String(result.channels).paddedLeft(' ', 4)
+                  << juce::String(result.blockSize).paddedLeft(' ', 7)
+                  << (juce::String(result.width) + "x" + juce::String(result.height)).paddedLeft(' ', 11)
+                  << juce::String(result.value, 3).paddedLeft(' ', 14) << " " << result.unit << "\n";
+    }
+
+    /** Runs body until at least minSeconds of it have been timed and returns
+        nanoseconds per call. setup runs before every call and is not timed.
+    */
+    template<typename Setup, typename Body>
+    double measureNanosPerCall(Setup&& setup, Body&& body, double minSeconds = 0.05)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            setup();
+            body();
+        }
+
+        juce::int64 ticks = 0;
+        juce::int64 calls = 0;
+        auto minTicks = static_cast<juce::int64>(minSeconds * juce::Time::getHighResolutionTicksPerSecond());
+
+        while (ticks < minTicks)
+        {
+            setup();
+            auto start = juce::Time::getHighResolutionTicks();
+            body();
+            ticks += juce::Time::getHighResolutionTicks() - start;
+            ++calls;
+        }
+
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / static_cast<double>(calls);
+    }
+
+    template<typename Body>
+    double measureNanosPerCall(Body&& body)
+    {
+        return measureNanosPerCall([] {}, std::forward<Body>(body));
+    }
+
+    void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(channel, i, random.nextFloat() * 2.2f - 1.1f);
+    }
+
+    std::vector<MeterKernels::Implementation> getImplementations()
+    {
+        using Implementation = MeterKernels::Implementation;
+        std::vector<Implementation> implementations;
+
+        for (auto implementation : { Implementation::Scalar, Implementation::SSE, Implementation::AVX2 })
+            if (MeterKernels::isSupported(implementation))
+                implementations.push_back(implementation);
+
+        return implementations;
+    }
+
+    //==============================================================================
+    /** State the analyser keeps across passes, checked before anything is
+        timed. Prints the first failure and returns false.
+    */
+    bool checkDistributions()
+    {
+        using Distribution = LevelDistribution<AnalysisResults::numDistributionBins>;
+        constexpr int blockSize = 32;
+        constexpr double windowLength = 30.0 * sampleRate;
+
+        // the analyser sets the mode again on every pass
+        Distribution session{ NEGATIVE_INFINITY, MAX_DECIBELS };
+        for (int pass = 0; pass < 100; ++pass)
+        {
+            session.setSession();
+            session.add(-20.0f, blockSize);
+        }
+
+        if (session.getTotalWeight() != 100.0 * blockSize)
+        {
+            std::cout << "FAILED: Session distribution holds " << session.getTotalWeight() << " samples instead of "
+                      << 100 * blockSize << "\n";
+            return false;
+        }
+
+        // a minute of small blocks must still fill the whole window
+        Distribution window{ NEGATIVE_INFINITY, MAX_DECIBELS };
+        for (int block = 0; block < 60 * static_cast<int>(sampleRate) / blockSize; ++block)
+        {
+            window.setWindow(windowLength);
+            window.add(-20.0f, blockSize);
+        }
+
+        if (window.getTotalWeight() < windowLength || window.getTotalWeight() > windowLength * 64.0 / 63.0 + blockSize)
+        {
+            std::cout << "FAILED: 30 s Window distribution holds " << window.getTotalWeight() / sampleRate << " s\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    void benchmarkKernels()
+    {
+        juce::Random random{ 1234 };
+        std::array<ChannelStats, MAX_CHANNELS> stats;
+        std::vector<float> history(MeterKernels::truePeakTaps - 1 + 8192);
+
+        for (auto numChannels : channelCounts)
+        {
+            for (int blockSize = 32; blockSize <= 8192; blockSize *= 4)
+            {
+                juce::AudioBuffer<float> buffer(numChannels, blockSize);
+                fillWithNoise(buffer, random);
+                auto samples = static_cast<double>(numChannels) * blockSize;
+
+                auto juceNanos = measureNanosPerCall([&]
+                {
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        sink = sink + buffer.getMagnitude(channel, 0, blockSize) + buffer.getRMSLevel(channel, 0, blockSize);
+                });
+                report({ "juce magnitude+rms", numChannels, blockSize, 0, 0, juceNanos / samples, "ns/sample" });
+
+                for (auto implementation : getImplementations())
+                {
+                    auto name = MeterKernels::getName(implementation);
+
+                    auto analyseNanos = measureNanosPerCall([&]
+                    {
+                        MeterKernels::analyse(buffer.getArrayOfReadPointers(), numChannels, blockSize, stats.data(), implementation);
+                        sink = sink + stats[0].absMax;
+                    });
+                    report({ "analyse/" + name, numChannels, blockSize, 0, 0, analyseNanos / samples, "ns/sample" });
+
+                    std::copy(buffer.getReadPointer(0), buffer.getReadPointer(0) + blockSize,
+                              history.begin() + MeterKernels::truePeakTaps - 1);
+                    auto truePeakNanos = measureNanosPerCall([&]
+                    {
+                        for (int channel = 0; channel < numChannels; ++channel)
+                            sink = sink + MeterKernels::truePeak(history.data() + MeterKernels::truePeakTaps - 1, blockSize, 1.0f, implementation).peak;
+                    });
+                    report({ "truePeak/" + name, numChannels, blockSize, 0, 0, truePeakNanos / samples, "ns/sample" });
+
+                    std::vector<double> state(numChannels * 4, 0.0), sums(numChannels, 0.0);
+                    BiquadCoefficients first, second;
+                    auto powerNanos = measureNanosPerCall([&]
+                    {
+                        MeterKernels::filteredPower(buffer.getArrayOfReadPointers(), numChannels, blockSize,
+                                                    first, second, state.data(), sums.data(), implementation);
+                        sink = sink + sums[0];
+                    });
+                    report({ "filteredPower/" + name, numChannels, blockSize, 0, 0, powerNanos / samples, "ns/sample" });
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    void prepareProcessor(PFMCPP_Project10AudioProcessor& processor, int numChannels, int blockSize)
+    {
+        auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+        if (channelSet.size() != numChannels)
+            channelSet = juce::AudioChannelSet::discreteChannels(numChannels);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.outputBuses.add(channelSet);
+        processor.setBusesLayout(layout);
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+    }
+
+    /** Only while processor.analyser.pauseAnalysis() is held, the analysis is the FIFOs' only other consumer. */
+    void drainFifos(PFMCPP_Project10AudioProcessor& processor, juce::AudioBuffer<float>& samples)
+    {
+        MeterRecord record;
+        while (processor.meterRecordFifo.pull(record)) {}
+        processor.audioBufferFifo.pull(samples);
+    }
+
+    void benchmarkProcessBlock()
+    {
+        juce::Random random{ 99 };
+        juce::MidiBuffer midi;
+        juce::AudioBuffer<float> drained;
+
+        for (auto numChannels : channelCounts)
+        {
+            for (int blockSize = 32; blockSize <= 1024; blockSize *= 2)
+            {
+                PFMCPP_Project10AudioProcessor processor;
+                prepareProcessor(processor, numChannels, blockSize);
+
+                juce::AudioBuffer<float> source(numChannels, blockSize), buffer(numChannels, blockSize);
+                fillWithNoise(source, random);
+
+                double nanos;
+                {
+                    // the FIFOs have a single consumer, so the shared analysis
+                    // workers leave them alone while the benchmark drains them
+                    auto pausedAnalysis = processor.analyser.pauseAnalysis();
+
+                    // the FIFOs are emptied between calls, as the analysis would
+                    nanos = measureNanosPerCall([&]
+                    {
+                        drainFifos(processor, drained);
+                        buffer.makeCopyOf(source, true);
+                    },
+                    [&]
+                    {
+                        processor.processBlock(buffer, midi);
+                    });
+                }
+
+                report({ "processBlock", numChannels, blockSize, 0, 0, nanos / 1000.0, "us/block" });
+                report({ "processBlock budget", numChannels, blockSize, 0, 0,
+                         100.0 * nanos * 1.0e-9 / (blockSize / sampleRate), "% of block" });
+
+                processor.releaseResources();
+            }
+        }
+    }
+
+    //==============================================================================
+    void benchmarkFifos()
+    {
+        Fifo<MeterRecord, 512> recordFifo;
+        MeterRecord record;
+        record.numChannels = 2;
+
+        auto recordNanos = measureNanosPerCall([&]
+        {
+            for (int i = 0; i < 256; ++i)
+                recordFifo.push(record);
+            for (int i = 0; i < 256; ++i)
+                recordFifo.pull(record);
+        });
+        report({ "Fifo<MeterRecord> push+pull", 0, 0, 0, 0, recordNanos / 256.0, "ns/record" });
+
+        juce::Random random{ 7 };
+        for (auto numChannels : channelCounts)
+        {
+            for (int blockSize = 32; blockSize <= 4096; blockSize *= 4)
+            {
+                SampleFifo<float> sampleFifo;
+                sampleFifo.prepare(numChannels, sampleRate, SAMPLE_FIFO_CAPACITY_MS);
+
+                juce::AudioBuffer<float> block(numChannels, blockSize), dest;
+                fillWithNoise(block, random);
+
+                auto nanos = measureNanosPerCall([&]
+                {
+                    sampleFifo.push(block);
+                    sink = sink + sampleFifo.pull(dest);
+                });
+                report({ "SampleFifo push+pull", numChannels, blockSize, 0, 0, nanos / 1000.0, "us/block" });
+            }
+        }
+    }
+
+    void benchmarkAverager()
+    {
+        juce::Random random{ 3 };
+
+        for (int size : { 6, 30, 120, 1000 })
+        {
+            Averager<float> averager(static_cast<size_t>(size), 0.0f);
+            std::vector<float> values(256);
+            for (auto& value : values)
+                value = random.nextFloat();
+
+            auto addNanos = measureNanosPerCall([&]
+            {
+                for (auto value : values)
+                    averager.add(value);
+                sink = sink + averager.getAvg();
+            });
+            report({ "Averager::add", 0, size, 0, 0, addNanos / values.size(), "ns/value" });
+
+            auto blockNanos = measureNanosPerCall([&]
+            {
+                averager.addBlock(values.data(), values.size());
+                sink = sink + averager.getAvg();
+            });
+            report({ "Averager::addBlock", 0, size, 0, 0, blockNanos / values.size(), "ns/value" });
+        }
+    }
+
+    void benchmarkBallistics()
+    {
+        juce::Random random{ 4 };
+
+        for (auto mode : { MeterBallistics::AverageMode::Rms, MeterBallistics::AverageMode::Vu })
+        {
+            for (int blockSize : { 64, 512 })
+            {
+                MeterBallistics ballistics;
+                ballistics.prepare(48000.0, 1);
+                ballistics.setAverage(mode, 2.0f);
+
+                juce::AudioBuffer<float> block(1, blockSize);
+                fillWithNoise(block, random);
+
+                auto nanos = measureNanosPerCall([&]
+                {
+                    ballistics.beginBlock(blockSize);
+                    sink = sink + ballistics.process(0, block.getReadPointer(0), blockSize).average;
+                });
+                report({ mode == MeterBallistics::AverageMode::Rms ? "MeterBallistics PPM+RMS" : "MeterBallistics PPM+VU",
+                         1, blockSize, 0, 0, nanos / blockSize, "ns/sample" });
+            }
+        }
+    }
+
+    //==============================================================================
+    template<typename ComponentType, typename Update>
+    void benchmarkComponent(const juce::String& name, ComponentType& component, int width, int height, Update&& update)
+    {
+        component.setSize(width, height);
+
+        juce::Image image(juce::Image::PixelFormat::ARGB, width, height, true, juce::SoftwareImageType());
+        juce::Graphics g(image);
+
+        auto nanos = measureNanosPerCall([&]
+        {
+            update();
+            component.paint(g);
+        });
+        report({ name, 0, 0, width, height, nanos / 1000.0, "us/frame" });
+    }
+
+    void benchmarkComponents()
+    {
+        juce::Random random{ 11 };
+
+        using Sizes = std::initializer_list<std::pair<int, int>>;
+
+        for (auto size : Sizes{ { 200, 30 }, { 400, 30 }, { 800, 40 } })
+        {
+            CorrelationMeter meter;
+            benchmarkComponent("CorrelationMeter", meter, size.first, size.second, [&]
+            {
+                meter.update(random.nextFloat() * 2.0f - 1.0f, random.nextFloat() * 2.0f - 1.0f);
+            });
+        }
+
+        for (auto size : Sizes{ { 300, 120 }, { 600, 120 }, { 1200, 240 } })
+        {
+            Histogram histogram{ "PEAK" };
+            benchmarkComponent("Histogram", histogram, size.first, size.second, [&]
+            {
+                histogram.update(juce::jmap(random.nextFloat(), NEGATIVE_INFINITY, MAX_DECIBELS));
+            });
+        }
+
+        auto goniometerResults = std::make_unique<AnalysisResults>();
+        goniometerResults->numGoniometerPoints = static_cast<int>(sampleRate * GONIOMETER_HISTORY_MS / 1000.0);
+        for (int i = 0; i < goniometerResults->numGoniometerPoints; ++i)
+            goniometerResults->goniometerPoints[i] = { random.nextFloat() - 0.5f, random.nextFloat() * 2.0f - 1.0f };
+
+        for (int size : { 150, 300, 600 })
+        {
+            Goniometer goniometer;
+            benchmarkComponent("Goniometer", goniometer, size, size, [&]
+            {
+                goniometer.update(*goniometerResults);
+            });
+        }
+
+        auto spectrumResults = std::make_unique<AnalysisResults>();
+        for (auto size : Sizes{ { 400, 160 }, { 800, 160 }, { 1600, 320 } })
+        {
+            SpectrumAnalyser analyser;
+            spectrumResults->numSpectrumColumns = size.first;
+            benchmarkComponent("SpectrumAnalyser", analyser, size.first, size.second, [&]
+            {
+                for (int column = 0; column < size.first; ++column)
+                    spectrumResults->spectrumDb[column] = juce::jmap(random.nextFloat(), SPECTRUM_MIN_DB, 0.0f);
+                analyser.update(*spectrumResults);
+            });
+        }
+    }
+
+    //==============================================================================
+    void benchmarkSpectrum()
+    {
+        juce::Random random{ 17 };
+
+        for (int order : { 11, 12, 13 })
+        {
+            for (int overlap : { 2, 4 })
+            {
+                SpectrumEngine engine;
+                engine.prepare(sampleRate, order, overlap);
+                engine.setColumns(1000, SPECTRUM_MIN_HZ, SPECTRUM_MAX_HZ);
+
+                // one hop per call, so every call analyses exactly one frame
+                auto hopSize = (1 << order) / overlap;
+                juce::AudioBuffer<float> buffer(2, hopSize);
+                fillWithNoise(buffer, random);
+
+                auto nanos = measureNanosPerCall([&]
+                {
+                    engine.process(buffer.getArrayOfReadPointers(), 2, hopSize);
+                    sink = sink + engine.getColumnLevels()[0];
+                });
+
+                auto framesPerSecond = sampleRate / hopSize;
+                report({ "SpectrumEngine " + juce::String(1 << order) + "/" + juce::String(overlap) + "x", 2, hopSize, 1000, 0,
+                         nanos / 1000.0, "us/frame" });
+                report({ "SpectrumEngine load", 2, hopSize, 1000, 0, 100.0 * nanos * 1.0e-9 * framesPerSecond, "% of a core" });
+            }
+        }
+    }
+
+    //==============================================================================
+    void benchmarkEditorFrames()
+    {
+        juce::Random random{ 5 };
+        juce::MidiBuffer midi;
+        constexpr int blockSize = 256;
+        constexpr int numFrames = 60;
+
+        for (auto numChannels : { 2, 6, MAX_CHANNELS })
+        {
+            PFMCPP_Project10AudioProcessor processor;
+            prepareProcessor(processor, numChannels, blockSize);
+
+            std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditor());
+            auto& meterEditor = dynamic_cast<PFMCPP_Project10AudioProcessorEditor&>(*editor);
+
+            juce::AudioBuffer<float> buffer(numChannels, blockSize);
+            auto blocksPerFrame = juce::roundToInt(sampleRate / ValueHolderBase::frameRate / blockSize);
+
+            double timerNanos = 0.0, paintNanos = 0.0;
+
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                for (int block = 0; block < blocksPerFrame; ++block)
+                {
+                    fillWithNoise(buffer, random);
+                    processor.processBlock(buffer, midi);
+                }
+
+                // gives the analysis thread one pass over the new audio
+                juce::Thread::sleep(1000 / ValueHolderBase::frameRate);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                meterEditor.timerCallback();
+                auto afterTimer = juce::Time::getHighResolutionTicks();
+
+                // the whole editor, as a full repaint would draw it
+                auto image = meterEditor.createComponentSnapshot(meterEditor.getLocalBounds(), true, 1.0f);
+                auto afterPaint = juce::Time::getHighResolutionTicks();
+
+                timerNanos += juce::Time::highResolutionTicksToSeconds(afterTimer - start) * 1.0e9;
+                paintNanos += juce::Time::highResolutionTicksToSeconds(afterPaint - afterTimer) * 1.0e9;
+                sink = sink + image.getWidth();
+            }
+
+            report({ "Editor::timerCallback", numChannels, blockSize, meterEditor.getWidth(), meterEditor.getHeight(),
+                     timerNanos / numFrames / 1000.0, "us/frame" });
+            report({ "Editor full paint", numChannels, blockSize, meterEditor.getWidth(), meterEditor.getHeight(),
+                     paintNanos / numFrames / 1000.0, "us/frame" });
+
+            editor.reset();
+            processor.releaseResources();
+        }
+    }
+
+    //==============================================================================
+    juce::String toCsv()
+    {
+        juce::StringArray lines{ "name,channels,block_size,width,height,value,unit" };
+
+        for (auto& result : results)
+            lines.add(juce::StringArray{ result.name.quoted(), juce::String(result.channels), juce::String(result.blockSize),
+                                         juce::String(result.width), juce::String(result.height),
+                                         juce::String(result.value, 4), result.unit }.joinIntoString(","));
+
+        return lines.joinIntoString("\n") + "\n";
+    }
+
+    juce::String toJson()
+    {
+        juce::Array<juce::var> rows;
+
+        for (auto& result : results)
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty("name", result.name);
+            object->setProperty("channels", result.channels);
+            object->setProperty("blockSize", result.blockSize);
+            object->setProperty("width", result.width);
+            object->setProperty("height", result.height);
+            object->setProperty("value", result.value);
+            object->setProperty("unit", result.unit);
+            rows.add(juce::var(object));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("kernel", MeterKernels::getName(MeterKernels::getBestImplementation()));
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("results", rows);
+
+        return juce::JSON::toString(juce::var(root));
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // components and the editor need a message manager, even offscreen
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    juce::File csvFile, jsonFile;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        juce::String argument(argv[i]);
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(argv[i + 1]);
+
+        if (argument == "--csv")
+            csvFile = file;
+        else if (argument == "--json")
+            jsonFile = file;
+    }
+
+    if (!checkDistributions())
+        return 1;
+
+    std::cout << "best kernel: " << MeterKernels::getName(MeterKernels::getBestImplementation()) << "\n\n";
+
+    benchmarkKernels();
+    benchmarkProcessBlock();
+    benchmarkFifos();
+    benchmarkAverager();
+    benchmarkBallistics();
+    benchmarkSpectrum();
+    benchmarkComponents();
+    benchmarkEditorFrames();
+
+    if (csvFile != juce::File())
+        csvFile.replaceWithText(toCsv());
+
+    if (jsonFile != juce::File())
+        jsonFile.replaceWithText(toJson());
+
+    return 0;
+}
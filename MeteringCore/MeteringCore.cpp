@@ -0,0 +1,18 @@
+/*
+  ==============================================================================
+
+    MeteringCore.cpp
+    The module's only compilation unit, the Projucer adds it to every project
+    that uses the module.
+
+  ==============================================================================
+*/
+
+#include "MeteringCore.h"
+
+#include "Source/MeterKernels.cpp"
+#include "Source/LoudnessEngine.cpp"
+#include "Source/MeterBallistics.cpp"
+#include "Source/MeterEngine.cpp"
+#include "Source/Ballistics.cpp"
+#include "Source/SpectrumEngine.cpp"
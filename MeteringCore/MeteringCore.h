@@ -0,0 +1,42 @@
+/*******************************************************************************
+ The block below describes the properties of this module, and is read by
+ the Projucer to add it to a project. Each project compiles MeteringCore.cpp
+ with its own JUCE configuration, so no binary links two builds of JUCE.
+
+ BEGIN_JUCE_MODULE_DECLARATION
+
+  ID:                 MeteringCore
+  vendor:             MordorkonanTestCompany
+  version:            1.0.0
+  name:               Metering core
+  description:        Signal analysis shared by the plugin, the benchmarks and the batch analyser.
+  dependencies:       juce_audio_basics, juce_dsp
+
+ END_JUCE_MODULE_DECLARATION
+
+*******************************************************************************/
+
+/*
+  ==============================================================================
+
+    MeteringCore.h
+    Depends on juce_core, juce_audio_basics and juce_dsp only: nothing in
+    here needs a message loop, a Timer or a Component.
+
+  ==============================================================================
+*/
+
+#pragma once
+#define METERINGCORE_H_INCLUDED
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include "Source/MeterKernels.h"
+#include "Source/LoudnessEngine.h"
+#include "Source/MeterBuffers.h"
+#include "Source/MeterBallistics.h"
+#include "Source/MeterEngine.h"
+#include "Source/Ballistics.h"
+#include "Source/SpectrumEngine.h"
+#include "Source/WorkStealingPool.h"
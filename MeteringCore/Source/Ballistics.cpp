@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    Ballistics.cpp
+
+  ==============================================================================
+*/
+
+#include "Ballistics.h"
+
+//==============================================================================
+void MeterClock::add(ValueHolderBase* holder) { holders.addIfNotAlreadyThere(holder); }
+
+void MeterClock::remove(ValueHolderBase* holder) { holders.removeFirstMatchingValue(holder); }
+
+bool MeterClock::tick()
+{
+    bool isAnimating = false;
+    for (auto* holder : holders)
+        isAnimating = holder->frameCallback() || isAnimating;
+
+    return isAnimating;
+}
+//==============================================================================
+void ManualClock::advance(juce::int64 ms)
+{
+    now += ms;
+    tick();
+}
+
+void ManualClock::advanceSamples(int numSamples, double sampleRate)
+{
+    remainderMs += 1000.0 * numSamples / sampleRate;
+    auto wholeMs = static_cast<juce::int64>(remainderMs);
+    remainderMs -= static_cast<double>(wholeMs);
+    advance(wholeMs);
+}
+//==============================================================================
+ValueHolderBase::ValueHolderBase(MeterClock& clock) : clock(clock)
+{
+    clock.add(this);
+}
+
+ValueHolderBase::~ValueHolderBase()
+{
+    clock.remove(this);
+}
+
+bool ValueHolderBase::frameCallback()
+{
+    if (infiniteHold)
+        return false;
+
+    auto wasAnimating = isAnimating();
+
+    if (getNow() - peakTime > holdTime)
+    {
+        frameCallbackImpl();
+    }
+
+    // also on the tick that ends the animation, so its last state gets shown
+    if (wasAnimating && onFrame)
+        onFrame();
+
+    return isAnimating();
+}
+
+void ValueHolderBase::wake() { clock.wake(); }
+
+void ValueHolderBase::setHoldTime(int ms)
+{
+    holdTime = ms;
+    if (holdTime == std::numeric_limits<int>::max()) { infiniteHold = true; }
+    else { infiniteHold = false; wake(); }
+}
+
+float ValueHolderBase::getCurrentValue() const { return currentValue; }
+
+bool ValueHolderBase::getIsOverThreshold() const { return currentValue > threshold; }
+
+bool ValueHolderBase::getInfiniteHold() const { return infiniteHold; }
+
+void ValueHolderBase::setThreshold(float th) { threshold = th; }
+
+float ValueHolderBase::getThreshold() const { return threshold; }
+
+juce::int64 ValueHolderBase::getNow() const { return clock.getNow(); }
+
+juce::int64 ValueHolderBase::getPeakTime() const { return peakTime; }
+
+juce::int64 ValueHolderBase::getHoldTime() const { return holdTime; }
+
+int ValueHolderBase::frameRate = 60;
+//==============================================================================
+ValueHolder::ValueHolder(MeterClock& clock) : ValueHolderBase(clock) { holdTime = 500; }
+
+ValueHolder::~ValueHolder() = default;
+
+void ValueHolder::updateHeldValue(float v)
+{
+    currentValue = v;
+
+    if (getIsOverThreshold() || infiniteHold)
+    {
+        if (holdTime == 0)
+        {
+            heldValue = v;
+        }
+        else
+        {
+            peakTime = getNow();
+            if (v > heldValue)
+            {
+                heldValue = v;
+            }
+        }
+
+        wake();
+    }    
+}
+
+void ValueHolder::frameCallbackImpl()
+{
+    
+    if (!getIsOverThreshold())
+    {
+        heldValue = NEGATIVE_INFINITY;
+    }
+}
+
+bool ValueHolder::isAnimating() const { return heldValue > NEGATIVE_INFINITY; }
+
+float ValueHolder::getValue() const
+{
+    bool check = getIsOverThreshold();
+    if (check || infiniteHold || getNow() - peakTime <= holdTime) { return heldValue; }
+    else { return currentValue; }
+}
+
+float ValueHolder::getHeldValue() const { return heldValue; }
+//==============================================================================
+DecayingValueHolder::DecayingValueHolder(MeterClock& clock) : ValueHolderBase(clock), decayRateMultiplier(1/*3*/)
+{
+    setDecayRate(3);
+}
+
+DecayingValueHolder::~DecayingValueHolder() = default;
+
+void DecayingValueHolder::updateHeldValue(float v)
+{
+    if (v > currentValue || v == NEGATIVE_INFINITY)
+    {
+        peakTime = getNow();
+        currentValue = v;
+        resetDecayRateMultiplier();
+        wake();
+    }
+}
+
+bool DecayingValueHolder::isAnimating() const { return currentValue > NEGATIVE_INFINITY; }
+
+void DecayingValueHolder::frameCallbackImpl()
+{
+    // the hold time itself never counts as decay time
+    auto now = getNow();
+    auto elapsedMs = static_cast<float>(now - juce::jmax(lastDecayTime, peakTime + holdTime));
+    lastDecayTime = now;
+
+    currentValue = juce::jlimit<float>(NEGATIVE_INFINITY,
+        MAX_DECIBELS,
+        currentValue - decayDbPerMs * elapsedMs * decayRateMultiplier);
+
+    decayRateMultiplier += decayAcceleration * elapsedMs / 1000.0f;
+
+    if (currentValue <= NEGATIVE_INFINITY)
+    {
+        resetDecayRateMultiplier();
+    }
+}
+
+void DecayingValueHolder::setDecayRate(float dbPerSec) { decayDbPerMs = dbPerSec / 1000.0f; }
+
+void DecayingValueHolder::resetDecayRateMultiplier() { decayRateMultiplier = 1; }
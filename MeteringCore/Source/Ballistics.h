@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    Ballistics.h
+    Peak hold and decay for meter displays. Time comes from a MeterClock, so
+    the same ballistics run from a GUI timer, from sample counts on a worker
+    thread or step by step in a benchmark.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define NEGATIVE_INFINITY -66.0f
+#define MAX_DECIBELS 12.0f
+//==============================================================================
+struct ValueHolderBase;
+
+/**
+    Time base and batch ticker for hold/decay objects. Holders read the time
+    from their clock and are advanced together by tick().
+*/
+struct MeterClock
+{
+    virtual ~MeterClock() = default;
+
+    virtual juce::int64 getNow() const = 0;
+    /** A holder has something to animate, a driven clock starts ticking here. */
+    virtual void wake() {}
+
+    void add(ValueHolderBase* holder);
+    void remove(ValueHolderBase* holder);
+    /** Advances every holder to getNow(), returns false once none of them is animating. */
+    bool tick();
+
+private:
+    juce::Array<ValueHolderBase*> holders;
+};
+//==============================================================================
+/** Deterministic clock that only moves when told to. */
+struct ManualClock : MeterClock
+{
+    juce::int64 getNow() const override { return now; }
+
+    /** Moves time forward and ticks the holders once. */
+    void advance(juce::int64 ms);
+    /** Moves time forward by the duration of numSamples, carrying the sub-millisecond rest. */
+    void advanceSamples(int numSamples, double sampleRate);
+
+private:
+    juce::int64 now{ 0 };
+    double remainderMs{ 0.0 };
+};
+//==============================================================================
+struct ValueHolderBase
+{
+    explicit ValueHolderBase(MeterClock& clock);
+    virtual ~ValueHolderBase();
+
+    virtual void updateHeldValue(float v) = 0;
+    /** Called by the MeterClock, returns false once nothing is left to animate. */
+    bool frameCallback();
+    virtual void frameCallbackImpl() = 0;
+    virtual bool isAnimating() const = 0;
+    void setThreshold(float th);
+    void setHoldTime(int ms);
+    float getCurrentValue() const;
+    bool getIsOverThreshold() const;
+    float getThreshold() const;
+    bool getInfiniteHold() const;
+
+    juce::int64 getPeakTime() const;
+    juce::int64 getHoldTime() const;
+    juce::int64 getNow() const;
+
+    static int frameRate;
+
+    /** Called after each tick of an animating holder, so whatever shows the
+        value can check whether its pixels changed without new input.
+    */
+    std::function<void()> onFrame;
+
+protected:
+    void wake();
+
+    bool infiniteHold{ false };
+    float threshold = 0.0f;
+    float currentValue = NEGATIVE_INFINITY;
+    juce::int64 peakTime = 0;   // 0 to prevent red textmeter at launch
+    juce::int64 holdTime = 2000;
+
+private:
+    MeterClock& clock;
+};
+//==============================================================================
+struct ValueHolder : ValueHolderBase
+{
+    explicit ValueHolder(MeterClock& clock);
+    ~ValueHolder();
+    void frameCallbackImpl() override;
+    bool isAnimating() const override;
+    void updateHeldValue(float v) override;
+    float getHeldValue() const;
+    float getValue() const;
+
+private:
+    float heldValue = NEGATIVE_INFINITY;
+};
+//==============================================================================
+struct DecayingValueHolder : ValueHolderBase
+{
+    explicit DecayingValueHolder(MeterClock& clock);
+    ~DecayingValueHolder();
+
+    void frameCallbackImpl() override;
+    bool isAnimating() const override;
+    void updateHeldValue(float v) override;
+
+    void setDecayRate(float dbPerSec);
+
+private:
+    // the decay speeds up the longer it runs, by this much of the rate per second
+    static constexpr float decayAcceleration = 3.0f;
+
+    float decayDbPerMs{ 0 };
+    float decayRateMultiplier{ 1 };
+    // decay is applied for the time that passed, however often the clock ticks
+    juce::int64 lastDecayTime{ 0 };
+
+    void resetDecayRateMultiplier();
+};
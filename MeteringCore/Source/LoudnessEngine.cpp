@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+    LoudnessEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "LoudnessEngine.h"
+
+//==============================================================================
+void GatingHistogram::clear()
+{
+    counts.fill(0);
+    meanSquares.fill(0.0);
+    numBlocks = 0;
+}
+
+int GatingHistogram::getBin(float lufs)
+{
+    return juce::jlimit(0, numBins - 1, static_cast<int>(std::floor((lufs - minLufs) / binWidth)));
+}
+
+void GatingHistogram::add(double meanSquare)
+{
+    auto lufs = LoudnessEngine::toLufs(meanSquare);
+    if (!(lufs >= minLufs))
+        return;
+
+    auto bin = getBin(lufs);
+    ++counts[bin];
+    meanSquares[bin] += meanSquare;
+    ++numBlocks;
+}
+
+float GatingHistogram::getGatedLoudness(float gateLufs) const
+{
+    // the gate is resolved to the bin it falls in, 0.1 LU
+    int count = 0;
+    double sum = 0.0;
+    for (int bin = gateLufs <= minLufs ? 0 : getBin(gateLufs); bin < numBins; ++bin)
+    {
+        count += counts[bin];
+        sum += meanSquares[bin];
+    }
+
+    return count > 0 ? LoudnessEngine::toLufs(sum / count) : -std::numeric_limits<float>::infinity();
+}
+
+float GatingHistogram::getPercentile(float gateLufs, float fraction) const
+{
+    auto firstBin = gateLufs <= minLufs ? 0 : getBin(gateLufs);
+
+    int total = 0;
+    for (int bin = firstBin; bin < numBins; ++bin)
+        total += counts[bin];
+
+    if (total == 0)
+        return -std::numeric_limits<float>::infinity();
+
+    auto target = fraction * total;
+    int cumulative = 0;
+    for (int bin = firstBin; bin < numBins; ++bin)
+    {
+        cumulative += counts[bin];
+        if (cumulative >= target)
+            return minLufs + (bin + 0.5f) * binWidth;
+    }
+
+    return maxLufs;
+}
+//==============================================================================
+void LoudnessEngine::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    // BS.1770 pre-filter (high shelf) and RLB high-pass, recomputed for the
+    // actual rate from their analog prototypes
+    {
+        auto K = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+        auto Q = 0.7071752369554196;
+        auto Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+        auto Vb = std::pow(Vh, 0.4996667741545416);
+        auto a0 = 1.0 + K / Q + K * K;
+
+        shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        shelf.b1 = 2.0 * (K * K - Vh) / a0;
+        shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        shelf.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+    {
+        auto K = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+        auto Q = 0.5003270373238773;
+        auto a0 = 1.0 + K / Q + K * K;
+
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+        highPass.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    numChannels = layout.size();
+    channelWeights.resize(numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        switch (layout.getTypeOfChannel(channel))
+        {
+            case juce::AudioChannelSet::LFE:
+            case juce::AudioChannelSet::LFE2:
+                channelWeights[channel] = 0.0;
+                break;
+            case juce::AudioChannelSet::leftSurround:
+            case juce::AudioChannelSet::rightSurround:
+            case juce::AudioChannelSet::leftSurroundSide:
+            case juce::AudioChannelSet::rightSurroundSide:
+            case juce::AudioChannelSet::leftSurroundRear:
+            case juce::AudioChannelSet::rightSurroundRear:
+                channelWeights[channel] = 1.41;
+                break;
+            default:
+                channelWeights[channel] = 1.0;
+                break;
+        }
+    }
+
+    filterState.assign(numChannels * 4, 0.0);
+    stepSumsOfSquares.assign(numChannels, 0.0);
+    channelPointers.resize(numChannels);
+
+    stepLength = juce::roundToInt(sampleRate * 0.1);
+    stepFill = 0;
+    stepMeanSquares.fill(0.0);
+    stepIndex = 0;
+    numSteps = 0;
+
+    values = Values();
+    resetIntegration();
+    resetRequested = false;
+}
+
+void LoudnessEngine::process(const juce::AudioBuffer<float>& buffer)
+{
+    if (resetRequested.exchange(false))
+        resetIntegration();
+
+    auto channels = juce::jmin(numChannels, buffer.getNumChannels());
+    if (channels == 0 || stepLength == 0)
+        return;
+
+    auto numSamples = buffer.getNumSamples();
+    for (int position = 0; position < numSamples;)
+    {
+        auto num = juce::jmin(numSamples - position, stepLength - stepFill);
+
+        for (int channel = 0; channel < channels; ++channel)
+            channelPointers[channel] = buffer.getReadPointer(channel, position);
+
+        MeterKernels::filteredPower(channelPointers.data(), channels, num, shelf, highPass,
+                                    filterState.data(), stepSumsOfSquares.data());
+
+        position += num;
+        stepFill += num;
+
+        if (stepFill == stepLength)
+            finishStep();
+    }
+}
+
+float LoudnessEngine::toLufs(double meanSquare)
+{
+    if (meanSquare <= 0.0)
+        return -std::numeric_limits<float>::infinity();
+
+    return static_cast<float>(-0.691 + 10.0 * std::log10(meanSquare));
+}
+
+void LoudnessEngine::finishStep()
+{
+    double meanSquare = 0.0;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        meanSquare += channelWeights[channel] * stepSumsOfSquares[channel];
+        stepSumsOfSquares[channel] = 0.0;
+    }
+
+    stepFill = 0;
+    stepIndex = (stepIndex + 1) % shortTermSteps;
+    stepMeanSquares[stepIndex] = meanSquare / stepLength;
+    numSteps = juce::jmin(numSteps + 1, shortTermSteps);
+
+    if (numSteps >= momentarySteps)
+    {
+        auto momentary = getMeanSquare(momentarySteps);
+        values.momentary = toLufs(momentary);
+
+        // integrated: absolute gate, then relative gate 10 LU below the
+        // loudness of everything that passed it
+        momentaryBlocks.add(momentary);
+        auto relativeGate = momentaryBlocks.getGatedLoudness(GatingHistogram::minLufs) - 10.0f;
+        values.integrated = momentaryBlocks.getGatedLoudness(relativeGate);
+    }
+
+    if (numSteps >= shortTermSteps)
+    {
+        auto shortTerm = getMeanSquare(shortTermSteps);
+        values.shortTerm = toLufs(shortTerm);
+
+        // EBU Tech 3342: 10th to 95th percentile of the short-term values
+        // above a relative gate 20 LU down
+        shortTermBlocks.add(shortTerm);
+        auto relativeGate = shortTermBlocks.getGatedLoudness(GatingHistogram::minLufs) - 20.0f;
+        values.range = shortTermBlocks.isEmpty() ? 0.0f
+                                                 : shortTermBlocks.getPercentile(relativeGate, 0.95f)
+                                                       - shortTermBlocks.getPercentile(relativeGate, 0.1f);
+    }
+}
+
+double LoudnessEngine::getMeanSquare(int steps) const
+{
+    double sum = 0.0;
+    for (int i = 0; i < steps; ++i)
+        sum += stepMeanSquares[(stepIndex - i + shortTermSteps) % shortTermSteps];
+
+    return sum / steps;
+}
+
+void LoudnessEngine::resetIntegration()
+{
+    momentaryBlocks.clear();
+    shortTermBlocks.clear();
+    values.integrated = -std::numeric_limits<float>::infinity();
+    values.range = 0.0f;
+}
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    LoudnessEngine.h
+    ITU-R BS.1770 / EBU R128 loudness: momentary, short-term, gated
+    integrated loudness and loudness range.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MeterKernels.h"
+
+//==============================================================================
+/**
+    Counts gating blocks by loudness in 0.1 LU bins and keeps the summed mean
+    square of each bin. Gated means and percentiles are computed from the bins,
+    so memory and cost stay the same however long the programme runs.
+*/
+struct GatingHistogram
+{
+    static constexpr float minLufs = -70.0f;     // absolute gate
+    static constexpr float maxLufs = 20.0f;      // louder blocks share the top bin
+    static constexpr float binWidth = 0.1f;
+    static constexpr int numBins = 900;
+
+    void clear();
+    /** Blocks below the absolute gate are ignored. */
+    void add(double meanSquare);
+    bool isEmpty() const { return numBlocks == 0; }
+
+    /** Loudness of the power mean of every block at or above gateLufs. */
+    float getGatedLoudness(float gateLufs) const;
+    /** Loudness below which fraction of the blocks at or above gateLufs fall. */
+    float getPercentile(float gateLufs, float fraction) const;
+
+private:
+    std::array<int, numBins> counts{};
+    std::array<double, numBins> meanSquares{};
+    int numBlocks{ 0 };
+
+    static int getBin(float lufs);
+};
+//==============================================================================
+/**
+    K-weighted loudness of the audio it is fed, computed on the audio thread.
+    Audio is integrated in 100 ms steps: momentary loudness uses the last four
+    (400 ms blocks with 75% overlap), short-term the last thirty (3 s).
+    Integrated loudness and loudness range come from GatingHistograms.
+*/
+struct LoudnessEngine
+{
+    struct Values
+    {
+        float momentary{ -std::numeric_limits<float>::infinity() };
+        float shortTerm{ -std::numeric_limits<float>::infinity() };
+        float integrated{ -std::numeric_limits<float>::infinity() };
+        float range{ 0.0f };
+    };
+
+    /** Allocates everything, call before process() and never from the audio thread. */
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void process(const juce::AudioBuffer<float>& buffer);
+    Values getValues() const { return values; }
+
+    /** Restarts integrated loudness and range, safe to call from any thread. */
+    void requestReset() { resetRequested = true; }
+
+    static float toLufs(double meanSquare);
+
+private:
+    static constexpr int shortTermSteps = 30;
+    static constexpr int momentarySteps = 4;
+
+    BiquadCoefficients shelf, highPass;
+    std::vector<double> filterState;       // four doubles per channel
+    std::vector<double> stepSumsOfSquares;
+    std::vector<double> channelWeights;
+    std::vector<const float*> channelPointers;
+    int numChannels{ 0 };
+
+    int stepLength{ 0 };
+    int stepFill{ 0 };
+
+    // weighted mean square of the last shortTermSteps steps, newest at stepIndex
+    std::array<double, shortTermSteps> stepMeanSquares{};
+    int stepIndex{ 0 };
+    int numSteps{ 0 };
+
+    GatingHistogram momentaryBlocks, shortTermBlocks;
+    Values values;
+    std::atomic<bool> resetRequested{ false };
+
+    void finishStep();
+    double getMeanSquare(int steps) const;
+    void resetIntegration();
+};
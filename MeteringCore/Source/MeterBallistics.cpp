@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    MeterBallistics.cpp
+
+  ==============================================================================
+*/
+
+#include "MeterBallistics.h"
+
+//==============================================================================
+void MeterBallistics::prepare(double newSampleRate, int numChannels)
+{
+    sampleRate = newSampleRate;
+    states.assign(static_cast<size_t>(numChannels), {});
+
+    ppmAttack = getOnePoleCoefficient(PPM_ATTACK_MS / 1000.0, sampleRate);
+    ppmRelease = static_cast<float>(juce::Decibels::decibelsToGain(-PPM_RETURN_DB_PER_SECOND / sampleRate));
+
+    averageIsRms = requestedMode.load() == static_cast<int>(AverageMode::Rms);
+    rmsTime.reset(sampleRate, rmsGlideSeconds);
+    rmsTime.setCurrentAndTargetValue(requestedRmsTime.load());
+    settingsChanged = false;
+    updateAverageCoefficient();
+}
+
+void MeterBallistics::reset()
+{
+    for (auto& state : states)
+        state = {};
+}
+
+void MeterBallistics::setAverage(AverageMode mode, float rmsTimeSeconds)
+{
+    requestedMode = static_cast<int>(mode);
+    if (mode == AverageMode::Rms)
+        requestedRmsTime = juce::jmax(0.001f, rmsTimeSeconds);
+    settingsChanged = true;
+}
+
+float MeterBallistics::getOnePoleCoefficient(double timeConstantSeconds, double sampleRate)
+{
+    return static_cast<float>(1.0 - std::exp(-1.0 / (timeConstantSeconds * sampleRate)));
+}
+
+void MeterBallistics::updateAverageCoefficient()
+{
+    auto averageTimeConstant = averageIsRms ? static_cast<double>(rmsTime.getCurrentValue())
+                                            : VU_RISE_MS / 1000.0 / std::log(100.0);
+    averageCoefficient = getOnePoleCoefficient(juce::jmax(0.001, averageTimeConstant), sampleRate);
+}
+
+void MeterBallistics::beginBlock(int numSamples)
+{
+    if (settingsChanged.exchange(false))
+    {
+        auto wasRms = averageIsRms;
+        averageIsRms = requestedMode.load() == static_cast<int>(AverageMode::Rms);
+
+        // switching law jumps, only a new RMS time glides
+        if (averageIsRms && wasRms)
+            rmsTime.setTargetValue(requestedRmsTime.load());
+        else if (averageIsRms)
+            rmsTime.setCurrentAndTargetValue(requestedRmsTime.load());
+
+        updateAverageCoefficient();
+    }
+
+    if (rmsTime.isSmoothing())
+    {
+        rmsTime.skip(numSamples);
+        updateAverageCoefficient();
+    }
+}
+
+MeterBallistics::Levels MeterBallistics::process(int channel, const float* data, int numSamples)
+{
+    auto& state = states[static_cast<size_t>(channel)];
+    auto ppm = state.ppm, average = state.average;
+    float maxPpm = 0.0f, maxAverage = 0.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto rectified = std::abs(data[i]);
+        ppm = rectified > ppm ? ppm + ppmAttack * (rectified - ppm) : ppm * ppmRelease;
+
+        auto input = averageIsRms ? rectified * rectified : rectified;
+        average += averageCoefficient * (input - average);
+
+        maxPpm = juce::jmax(maxPpm, ppm);
+        maxAverage = juce::jmax(maxAverage, average);
+    }
+
+    // keeps the release from running into denormals during silence
+    state.ppm = ppm < 1.0e-15f ? 0.0f : ppm;
+    state.average = average < 1.0e-15f ? 0.0f : average;
+
+    // the rectified mean of a sine is 2 / pi of its peak, its RMS 1 / sqrt 2
+    static constexpr float vuScale = juce::MathConstants<float>::pi / (2.0f * juce::MathConstants<float>::sqrt2);
+    return { maxPpm, averageIsRms ? std::sqrt(maxAverage) : maxAverage * vuScale };
+}
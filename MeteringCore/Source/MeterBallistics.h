@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    MeterBallistics.h
+    Standard meter ballistics as per-sample recursive integrators, run on the
+    audio thread with time constants derived from the sample rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// IEC 60268-10 Type I: a 5 ms 5 kHz burst reads 2 dB below the steady tone,
+// which this one-pole attack on the rectified signal reproduces
+#define PPM_ATTACK_MS 1.35
+#define PPM_RETURN_DB_PER_SECOND (20.0 / 1.5)
+#define VU_RISE_MS 300.0                // IEC 60268-17, 99% of the final reading
+//==============================================================================
+/**
+    Two integrators per channel, each a single state variable, so any
+    averaging time costs the same and needs no history:
+    - a quasi-peak programme meter: one-pole attack on the rectified signal
+      and an exponential return at a fixed dB/s,
+    - an average: a one-pole on the squared signal (RMS with the chosen time
+      constant) or on the rectified signal (VU, scaled to read a sine's RMS).
+    A one-pole VU rises without the 1-1.5% overshoot of a needle.
+    Levels are linear; process() returns the highest value each integrator
+    reached during the block, so no attack is lost between display frames.
+*/
+struct MeterBallistics
+{
+    enum class AverageMode { Rms, Vu };
+
+    struct Levels
+    {
+        float ppm{ 0.0f };
+        float average{ 0.0f };
+    };
+
+    /** Allocates the channel states, call before process() and never from the audio thread. */
+    void prepare(double sampleRate, int numChannels);
+    void reset();
+
+    /** Safe to call from any thread, picked up at the start of the next block.
+        A new RMS time glides in over rmsGlideSeconds, rmsTimeSeconds is ignored for VU.
+    */
+    void setAverage(AverageMode mode, float rmsTimeSeconds);
+
+    /** Audio thread, once per block before the channels are processed. */
+    void beginBlock(int numSamples);
+    Levels process(int channel, const float* data, int numSamples);
+
+private:
+    struct State
+    {
+        float ppm{ 0.0f };
+        float average{ 0.0f };      // mean square or rectified mean
+    };
+
+    static constexpr double rmsGlideSeconds = 0.1;
+
+    static float getOnePoleCoefficient(double timeConstantSeconds, double sampleRate);
+    void updateAverageCoefficient();
+
+    double sampleRate{ 48000.0 };
+    std::vector<State> states;
+
+    float ppmAttack{ 1.0f }, ppmRelease{ 1.0f };
+    float averageCoefficient{ 1.0f };
+    bool averageIsRms{ true };
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> rmsTime{ 0.5f };
+
+    std::atomic<int> requestedMode{ static_cast<int>(AverageMode::Rms) };
+    std::atomic<float> requestedRmsTime{ 0.5f };
+    std::atomic<bool> settingsChanged{ true };
+};
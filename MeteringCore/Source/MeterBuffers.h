@@ -0,0 +1,506 @@
+/*
+  ==============================================================================
+
+    MeterBuffers.h
+    Lock-free hand-over and averaging containers shared by the audio thread,
+    the analysis thread and offline tools.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MeterKernels.h"
+
+//==============================================================================
+template<typename T>
+struct Averager
+{
+    Averager(size_t numElements, T initialValue)
+    {
+        resize(numElements, initialValue);
+    }
+
+    void resize(size_t numElements, T initialValue)
+    {
+        elements.resize(numElements);
+        clear(initialValue);
+    }
+
+    void clear(T initialValue)
+    {
+        for (auto& element : elements)
+        {
+            element = initialValue;
+        }
+        
+        writeIndex = 0;
+        sum = static_cast<double>(initialValue) * elements.size();
+        avg = static_cast<float>(initialValue);
+    }
+
+    size_t getSize() const { return elements.size(); }
+
+    void add(T t)
+    {
+        auto currentIndex = writeIndex.load();
+
+        sum = sum - elements[currentIndex] + t;
+        elements[currentIndex] = t;
+        ++currentIndex;
+        if (currentIndex == elements.size())
+        {
+            currentIndex = 0;
+            // a fresh sum once per lap keeps rounding errors from piling up
+            sum = sumOf(elements.data(), elements.size());
+        }
+
+        writeIndex.store(currentIndex);
+        avg.store(static_cast<float>(sum / elements.size()));
+    }
+
+    /** Adds numValues at once: bulk copies into the ring, updates the sum by
+        the difference of the new and the overwritten values and publishes the
+        average once.
+    */
+    void addBlock(const T* data, size_t numValues)
+    {
+        auto size = elements.size();
+
+        // only the newest size values can survive the block
+        if (numValues > size)
+        {
+            data += numValues - size;
+            numValues = size;
+        }
+
+        auto currentIndex = writeIndex.load();
+        auto first = juce::jmin(numValues, size - currentIndex);
+
+        if (currentIndex + numValues < size)
+            sum += sumOf(data, numValues) - sumOf(elements.data() + currentIndex, numValues);
+
+        std::copy(data, data + first, elements.begin() + currentIndex);
+        std::copy(data + first, data + numValues, elements.begin());
+
+        currentIndex += numValues;
+        if (currentIndex >= size)
+        {
+            currentIndex -= size;
+            sum = sumOf(elements.data(), size);
+        }
+
+        writeIndex.store(currentIndex);
+        avg.store(static_cast<float>(sum / size));
+    }
+
+    float getAvg() const { return avg; }
+
+private:
+    // the exact float overload wins over the template, so only floats use the kernel
+    static double sumOf(const float* data, size_t numValues)
+    {
+        return MeterKernels::sum(data, static_cast<int>(numValues));
+    }
+
+    template<typename Value>
+    static double sumOf(const Value* data, size_t numValues)
+    {
+        double total = 0.0;
+        for (size_t i = 0; i < numValues; ++i)
+            total += data[i];
+        return total;
+    }
+
+    std::vector<T> elements;
+    std::atomic<float> avg{ static_cast<float>(T()) };
+    std::atomic<size_t> writeIndex{ 0 };
+    // only touched by the writer, double so long sessions don't drift
+    double sum{ 0.0 };
+};
+//==============================================================================
+template<typename T, size_t Size>
+struct Fifo
+{
+    size_t getSize() const noexcept
+    {
+        return Size;
+    }
+
+    void prepare(int numSamples, int numChannels)
+    {
+        for (auto& bufferCell : buffer)
+        {
+            // setSize() and clear() are taken from AudioBuffer<Type> class
+            bufferCell.setSize(numChannels,
+                       numSamples,
+                       false,
+                       true,
+                       false);
+
+            bufferCell.clear();
+        }
+    }
+
+    bool push(const T& t)
+    {
+        auto write = fifo.write(1);
+        if (write.blockSize1 > 0)
+        {
+            buffer[write.startIndex1] = t;
+            return true;
+        }
+        return false;
+    }
+    bool pull(T& t)
+    {   
+        auto read = fifo.read(1);
+        if (read.blockSize1 > 0)
+        {
+            t = buffer[read.startIndex1];
+            return true;
+        }
+        return false;
+    }
+
+    int getNumAvailableForReading() const
+    {
+        return fifo.getNumReady();
+    }
+    int getAvailableSpace() const
+    {
+        return fifo.getFreeSpace();
+    }
+
+private:
+    juce::AbstractFifo fifo{ Size };
+    std::array<T, Size> buffer;
+};
+//==============================================================================
+/**
+    Single-producer/single-consumer ring of raw channel samples.
+    All storage is allocated in prepare(), push() only copies samples into the
+    ring so it can be called from the audio thread.
+*/
+template<typename T>
+struct SampleFifo
+{
+    void prepare(int numChannels, double sampleRate, double capacityMs)
+    {
+        auto capacity = static_cast<int>(std::ceil(sampleRate * capacityMs / 1000.0));
+
+        // AbstractFifo keeps one slot free to tell "full" from "empty"
+        buffer.setSize(numChannels, capacity + 1, false, true, false);
+        buffer.clear();
+        fifo.setTotalSize(capacity + 1);
+    }
+
+    bool push(const juce::AudioBuffer<T>& source)
+    {
+        auto numSamples = source.getNumSamples();
+        if (numSamples > fifo.getFreeSpace())
+            return false;
+
+        auto numChannels = juce::jmin(source.getNumChannels(), buffer.getNumChannels());
+        auto write = fifo.write(numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            if (write.blockSize1 > 0)
+                buffer.copyFrom(channel, write.startIndex1, source, channel, 0, write.blockSize1);
+            if (write.blockSize2 > 0)
+                buffer.copyFrom(channel, write.startIndex2, source, channel, write.blockSize1, write.blockSize2);
+        }
+
+        return true;
+    }
+
+    /** Moves every pending sample into dest and returns how many were read.
+        dest is resized with avoidReallocating, so after the first call it only
+        allocates if the ring capacity grows.
+    */
+    int pull(juce::AudioBuffer<T>& dest)
+    {
+        auto read = fifo.read(fifo.getNumReady());
+        auto numSamples = read.blockSize1 + read.blockSize2;
+        dest.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            if (read.blockSize1 > 0)
+                dest.copyFrom(channel, 0, buffer, channel, read.startIndex1, read.blockSize1);
+            if (read.blockSize2 > 0)
+                dest.copyFrom(channel, read.blockSize1, buffer, channel, read.startIndex2, read.blockSize2);
+        }
+
+        return numSamples;
+    }
+
+    /** Drops every pending sample, for a consumer that has no use for them right now. */
+    void discard() { fifo.finishedRead(fifo.getNumReady()); }
+
+    int getNumChannels() const { return buffer.getNumChannels(); }
+
+    int getNumAvailableForReading() const
+    {
+        return fifo.getNumReady();
+    }
+    int getAvailableSpace() const
+    {
+        return fifo.getFreeSpace();
+    }
+
+private:
+    juce::AbstractFifo fifo{ 1 };
+    juce::AudioBuffer<T> buffer;
+};
+//==============================================================================
+/**
+    Lock-free hand-over of the latest value from one writer thread to one reader
+    thread. Three slots are used so that neither side ever waits: the writer
+    fills its back slot and swaps it with the shared middle slot, the reader
+    swaps the middle slot with its front slot when something new was published.
+*/
+template<typename T>
+struct SnapshotBuffer
+{
+    /** Writer only */
+    T& getWriteBuffer() { return slots[writeIndex]; }
+
+    /** Writer only */
+    void publish()
+    {
+        auto previous = middle.exchange(writeIndex | freshFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    /** Reader only, returns false if nothing was published since the last call */
+    bool update()
+    {
+        if ((middle.load(std::memory_order_acquire) & freshFlag) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    /** Reader only */
+    const T& getReadBuffer() const { return slots[readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<T, 3> slots;
+    std::atomic<int> middle{ 1 };
+    int writeIndex{ 0 }, readIndex{ 2 };
+};
+//==============================================================================
+/**
+    Statistical distribution of levels over fixed-width dB bins.
+    Adding a value is O(1) in every mode (amortised in Window mode) and
+    percentile queries are O(NumBins), memory is fixed at construction however
+    long the session runs and however small the added weights are.
+    Values are weighted, e.g. by their number of samples, so the distribution
+    is over time rather than over blocks.
+*/
+template<int NumBins>
+struct LevelDistribution
+{
+    enum class Mode { Session, Decay, Window };
+
+    LevelDistribution(float minDb_, float maxDb_) :
+        minDb(minDb_),
+        binWidth((maxDb_ - minDb_) / NumBins)
+    {
+        windowSlots.resize(numWindowSlots);
+        clear();
+    }
+
+    void clear()
+    {
+        bins.fill(0.0);
+        total = 0.0;
+        scale = 1.0;
+
+        for (auto& slot : windowSlots)
+            slot.fill(0.0);
+        windowSlot = 0;
+        windowSlotWeight = 0.0;
+    }
+
+    /** Counts everything since the last clear(). */
+    void setSession() { setMode(Mode::Session, 0.0); }
+    /** Older values fade out exponentially with the given time constant. */
+    void setDecay(double timeConstantWeight) { setMode(Mode::Decay, timeConstantWeight); }
+    /** Only the newest values count. They expire a slot of lengthWeight / 63 at
+        a time, so the window holds between lengthWeight and 64 / 63 of it.
+    */
+    void setWindow(double lengthWeight) { setMode(Mode::Window, lengthWeight); }
+
+    Mode getMode() const { return mode; }
+    /** The weight the percentiles are currently taken over. */
+    double getTotalWeight() const { return total / scale; }
+
+    void add(float db, double weight)
+    {
+        auto bin = getBin(db);
+
+        if (mode == Mode::Decay)
+        {
+            // instead of decaying every bin, new values get a growing weight
+            scale *= std::exp(weight / modeParameter);
+            if (scale > 1.0e100)
+                renormalise();
+            weight *= scale;
+        }
+
+        bins[bin] += weight;
+        total += weight;
+
+        if (mode == Mode::Window)
+        {
+            if (windowSlotWeight >= modeParameter / (numWindowSlots - 1))
+                startWindowSlot();
+
+            windowSlots[static_cast<size_t>(windowSlot)][bin] += weight;
+            windowSlotWeight += weight;
+        }
+    }
+
+    /** Level below which the given fraction (0...1) of the weight lies. */
+    float getPercentile(float fraction) const
+    {
+        if (total <= 0.0)
+            return minDb;
+
+        auto target = total * juce::jlimit(0.0f, 1.0f, fraction);
+        double cumulative = 0.0;
+
+        for (int bin = 0; bin < NumBins; ++bin)
+        {
+            if (bins[bin] > 0.0 && cumulative + bins[bin] >= target)
+            {
+                auto withinBin = static_cast<float>((target - cumulative) / bins[bin]);
+                return getBinStartDb(bin) + withinBin * binWidth;
+            }
+            cumulative += bins[bin];
+        }
+
+        return getBinStartDb(NumBins);
+    }
+
+    /** Writes every bin as a fraction of the total weight. */
+    void getFractions(std::array<float, NumBins>& dest) const
+    {
+        auto norm = total > 0.0 ? 1.0 / total : 0.0;
+        for (int bin = 0; bin < NumBins; ++bin)
+            dest[bin] = static_cast<float>(bins[bin] * norm);
+    }
+
+    float getBinStartDb(int bin) const { return minDb + bin * binWidth; }
+
+private:
+    static constexpr int numWindowSlots = 64;
+
+    void setMode(Mode newMode, double parameter)
+    {
+        // compared after clamping, or a Session mode set every pass would clear every pass
+        parameter = juce::jmax(1.0, parameter);
+        if (newMode == mode && parameter == modeParameter)
+            return;
+
+        mode = newMode;
+        modeParameter = parameter;
+        clear();
+    }
+
+    int getBin(float db) const
+    {
+        return juce::jlimit(0, NumBins - 1, static_cast<int>((db - minDb) / binWidth));
+    }
+
+    /** Moves on to the next slot and takes the oldest one out of the bins. */
+    void startWindowSlot()
+    {
+        windowSlot = (windowSlot + 1) % numWindowSlots;
+        auto& oldest = windowSlots[static_cast<size_t>(windowSlot)];
+
+        // the total is summed again so subtracting never leaves it drifting
+        total = 0.0;
+        for (int bin = 0; bin < NumBins; ++bin)
+        {
+            bins[bin] = juce::jmax(0.0, bins[bin] - oldest[bin]);
+            total += bins[bin];
+        }
+
+        oldest.fill(0.0);
+        windowSlotWeight = 0.0;
+    }
+
+    void renormalise()
+    {
+        for (auto& bin : bins)
+            bin /= scale;
+        total /= scale;
+        scale = 1.0;
+    }
+
+    const float minDb, binWidth;
+    Mode mode{ Mode::Session };
+    double modeParameter{ 1.0 };
+
+    std::array<double, NumBins> bins;
+    double total{ 0.0 }, scale{ 1.0 };
+
+    std::vector<std::array<double, NumBins>> windowSlots;
+    int windowSlot{ 0 };
+    double windowSlotWeight{ 0.0 };
+};
+//==============================================================================
+template<typename T>
+struct ReadAllAfterWriteCircularBuffer
+{
+    using DataType = std::vector<T>;
+    ReadAllAfterWriteCircularBuffer(T fillValue) { data.resize(1, fillValue); }
+
+    void resize(std::size_t s, T fillValue)
+    {
+        data.resize(s, fillValue);
+        resetWriteIndex();
+    }
+
+    void clear(T fillValue)
+    {
+        for (int i = 0; i < data.size(); ++i)
+        {
+            data[i] = fillValue;
+        }
+
+        resetWriteIndex();
+    }
+    void write(T t)
+    {
+        auto index = writeIndex.load();
+        data[index] = t;
+        ++index;
+        if (index == data.size())
+        {
+            index = 0;
+        }
+        writeIndex.store(index);
+    }
+
+    DataType& getData() { return data; }
+
+    size_t getReadIndex() const { return writeIndex.load(); }
+
+    size_t getSize() const { return data.size(); }
+
+private:
+    void resetWriteIndex() { writeIndex.store(0); }
+
+    std::atomic<std::size_t> writeIndex{ 0 };
+    DataType data;
+};
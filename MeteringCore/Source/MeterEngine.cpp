@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    MeterEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "MeterEngine.h"
+
+//==============================================================================
+void MeterEngine::prepare(double sampleRate)
+{
+    // the buffer can carry more channels than the input bus
+    truePeakDetector.prepare(MAX_CHANNELS);
+    ballistics.prepare(sampleRate, MAX_CHANNELS);
+    overLevel = juce::Decibels::decibelsToGain(TRUE_PEAK_LIMIT_DBTP);
+}
+
+MeterRecord MeterEngine::process(const juce::AudioBuffer<float>& buffer)
+{
+    MeterRecord record;
+    record.numSamples = buffer.getNumSamples();
+
+    auto numChannels = juce::jmin(buffer.getNumChannels(), MAX_CHANNELS);
+    record.numChannels = numChannels;
+
+    std::array<ChannelStats, MAX_CHANNELS> stats;
+    MeterKernels::analyse(buffer.getArrayOfReadPointers(), numChannels, record.numSamples, stats.data());
+    ballistics.beginBlock(record.numSamples);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& meterChannel = record.channels[channel];
+        meterChannel.sumOfSquares = static_cast<float>(stats[channel].sumOfSquares);
+
+        auto truePeak = truePeakDetector.process(channel, buffer.getReadPointer(channel), record.numSamples, overLevel);
+        meterChannel.truePeak = truePeak.peak;
+        meterChannel.numOvers = truePeak.numOvers;
+
+        auto levels = ballistics.process(channel, buffer.getReadPointer(channel), record.numSamples);
+        meterChannel.ppm = levels.ppm;
+        meterChannel.average = levels.average;
+    }
+
+    return record;
+}
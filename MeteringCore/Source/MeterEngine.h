@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    MeterEngine.h
+    Per-block level, true peak and correlation sums, computed on the audio
+    thread and passed on as a fixed-size MeterRecord.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MeterKernels.h"
+#include "LoudnessEngine.h"
+#include "MeterBallistics.h"
+
+#define MAX_CHANNELS 12     // 7.1.4
+#define TRUE_PEAK_LIMIT_DBTP -1.0f     // EBU R128 maximum true peak
+//==============================================================================
+/**
+    Running peak and energy of one channel. Blocks of any size can be folded
+    in with add() or merge(), the RMS stays energy-correct because the sum of
+    squares and the sample count are kept instead of per-block RMS values.
+*/
+struct LevelAccumulator
+{
+    void reset()
+    {
+        peak = 0.0f;
+        sumOfSquares = 0.0;
+        numSamples = 0;
+    }
+
+    void add(const float* data, int num)
+    {
+        auto localPeak = peak;
+        double localSum = 0.0;
+
+        for (int i = 0; i < num; ++i)
+        {
+            auto sample = data[i];
+            localPeak = juce::jmax(localPeak, std::abs(sample));
+            localSum += static_cast<double>(sample) * sample;
+        }
+
+        peak = localPeak;
+        sumOfSquares += localSum;
+        numSamples += num;
+    }
+
+    void add(float blockPeak, double blockSumOfSquares, int blockNumSamples)
+    {
+        peak = juce::jmax(peak, blockPeak);
+        sumOfSquares += blockSumOfSquares;
+        numSamples += blockNumSamples;
+    }
+
+    void merge(const LevelAccumulator& other)
+    {
+        add(other.peak, other.sumOfSquares, other.numSamples);
+    }
+
+    float getPeak() const { return peak; }
+
+    float getRMS() const
+    {
+        return numSamples > 0 ? static_cast<float>(std::sqrt(sumOfSquares / numSamples)) : 0.0f;
+    }
+
+    int getNumSamples() const { return numSamples; }
+
+private:
+    float peak{ 0.0f };
+    double sumOfSquares{ 0.0 };
+    int numSamples{ 0 };
+};
+//==============================================================================
+/**
+    Compact summary of one processBlock() call, produced on the audio thread.
+    It only carries what the analysis reads; correlation and the other stereo
+    views work on the raw samples. The channel array is fixed-size so records
+    of any layout travel through the same preallocated Fifo.
+*/
+struct MeterRecord
+{
+    struct Channel
+    {
+        float sumOfSquares{ 0.0f };
+        float truePeak{ 0.0f };
+        // samples whose true peak reached TRUE_PEAK_LIMIT_DBTP
+        int numOvers{ 0 };
+        // highest readings of the MeterBallistics integrators during the block
+        float ppm{ 0.0f };
+        float average{ 0.0f };
+    };
+
+    std::array<Channel, MAX_CHANNELS> channels;
+    int numChannels{ 0 };
+    int numSamples{ 0 };
+    // as of the end of this block
+    LoudnessEngine::Values loudness;
+};
+//==============================================================================
+struct MeterEngine
+{
+    void prepare(double sampleRate);
+    MeterRecord process(const juce::AudioBuffer<float>& buffer);
+
+    /** Safe to call from any thread. */
+    void setAverageBallistics(MeterBallistics::AverageMode mode, float rmsTimeSeconds) { ballistics.setAverage(mode, rmsTimeSeconds); }
+
+private:
+    TruePeakDetector truePeakDetector;
+    MeterBallistics ballistics;
+    float overLevel{ 1.0f };
+};
@@ -0,0 +1,850 @@
+/*
+  ==============================================================================
+
+    MeterKernels.cpp
+
+  ==============================================================================
+*/
+
+#include "MeterKernels.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+
+ #if JUCE_GCC || JUCE_CLANG
+  #define METER_KERNELS_AVX2_TARGET __attribute__((target("avx2")))
+ #else
+  #define METER_KERNELS_AVX2_TARGET
+ #endif
+#endif
+
+namespace
+{
+    // vector lanes accumulate in float, so they are flushed into the double
+    // totals every few hundred samples to keep long blocks accurate
+    constexpr int flushInterval = 256;
+
+    using ChannelKernel = void (*)(const float*, int, ChannelStats&);
+
+    void finish(ChannelStats& stats, int numSamples)
+    {
+        if (numSamples == 0)
+        {
+            stats = ChannelStats();
+            return;
+        }
+
+        stats.absMax = juce::jmax(-stats.min, stats.max);
+    }
+
+    void analyseScalarRange(const float* data, int start, int end, ChannelStats& stats)
+    {
+        for (int i = start; i < end; ++i)
+        {
+            auto sample = data[i];
+            stats.min = juce::jmin(stats.min, sample);
+            stats.max = juce::jmax(stats.max, sample);
+            stats.sumOfSquares += static_cast<double>(sample) * sample;
+            stats.sum += sample;
+            stats.clipCount += std::abs(sample) >= MeterKernels::clipLevel ? 1 : 0;
+        }
+    }
+
+    void analyseScalar(const float* data, int numSamples, ChannelStats& stats)
+    {
+        stats = ChannelStats();
+        stats.min = std::numeric_limits<float>::max();
+        stats.max = std::numeric_limits<float>::lowest();
+
+        analyseScalarRange(data, 0, numSamples, stats);
+        finish(stats, numSamples);
+    }
+
+   #if JUCE_INTEL
+    void analyseSSE(const float* data, int numSamples, ChannelStats& stats)
+    {
+        stats = ChannelStats();
+
+        const auto absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const auto clip = _mm_set1_ps(MeterKernels::clipLevel);
+
+        auto minV = _mm_set1_ps(std::numeric_limits<float>::max());
+        auto maxV = _mm_set1_ps(std::numeric_limits<float>::lowest());
+        auto clipsV = _mm_setzero_si128();
+
+        const int numVectorised = numSamples & ~3;
+        int i = 0;
+
+        while (i < numVectorised)
+        {
+            auto chunkEnd = juce::jmin(numVectorised, i + flushInterval);
+            auto squaresV = _mm_setzero_ps();
+            auto sumV = _mm_setzero_ps();
+
+            for (; i < chunkEnd; i += 4)
+            {
+                auto x = _mm_loadu_ps(data + i);
+                minV = _mm_min_ps(minV, x);
+                maxV = _mm_max_ps(maxV, x);
+                squaresV = _mm_add_ps(squaresV, _mm_mul_ps(x, x));
+                sumV = _mm_add_ps(sumV, x);
+                // a true comparison is all ones, i.e. -1
+                clipsV = _mm_sub_epi32(clipsV, _mm_castps_si128(_mm_cmpge_ps(_mm_and_ps(x, absMask), clip)));
+            }
+
+            alignas(16) float squares[4], sums[4];
+            _mm_store_ps(squares, squaresV);
+            _mm_store_ps(sums, sumV);
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                stats.sumOfSquares += squares[lane];
+                stats.sum += sums[lane];
+            }
+        }
+
+        alignas(16) float mins[4], maxs[4];
+        alignas(16) int clips[4];
+        _mm_store_ps(mins, minV);
+        _mm_store_ps(maxs, maxV);
+        _mm_store_si128(reinterpret_cast<__m128i*>(clips), clipsV);
+
+        stats.min = juce::jmin(mins[0], mins[1], mins[2], mins[3]);
+        stats.max = juce::jmax(maxs[0], maxs[1], maxs[2], maxs[3]);
+        stats.clipCount = clips[0] + clips[1] + clips[2] + clips[3];
+
+        analyseScalarRange(data, numVectorised, numSamples, stats);
+        finish(stats, numSamples);
+    }
+
+    METER_KERNELS_AVX2_TARGET
+    void analyseAVX2(const float* data, int numSamples, ChannelStats& stats)
+    {
+        stats = ChannelStats();
+
+        const auto absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        const auto clip = _mm256_set1_ps(MeterKernels::clipLevel);
+
+        auto minV = _mm256_set1_ps(std::numeric_limits<float>::max());
+        auto maxV = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+        auto clipsV = _mm256_setzero_si256();
+
+        const int numVectorised = numSamples & ~7;
+        int i = 0;
+
+        while (i < numVectorised)
+        {
+            auto chunkEnd = juce::jmin(numVectorised, i + flushInterval);
+            auto squaresV = _mm256_setzero_ps();
+            auto sumV = _mm256_setzero_ps();
+
+            for (; i < chunkEnd; i += 8)
+            {
+                auto x = _mm256_loadu_ps(data + i);
+                minV = _mm256_min_ps(minV, x);
+                maxV = _mm256_max_ps(maxV, x);
+                squaresV = _mm256_add_ps(squaresV, _mm256_mul_ps(x, x));
+                sumV = _mm256_add_ps(sumV, x);
+                clipsV = _mm256_sub_epi32(clipsV, _mm256_castps_si256(_mm256_cmp_ps(_mm256_and_ps(x, absMask), clip, _CMP_GE_OQ)));
+            }
+
+            alignas(32) float squares[8], sums[8];
+            _mm256_store_ps(squares, squaresV);
+            _mm256_store_ps(sums, sumV);
+
+            for (int lane = 0; lane < 8; ++lane)
+            {
+                stats.sumOfSquares += squares[lane];
+                stats.sum += sums[lane];
+            }
+        }
+
+        alignas(32) float mins[8], maxs[8];
+        alignas(32) int clips[8];
+        _mm256_store_ps(mins, minV);
+        _mm256_store_ps(maxs, maxV);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(clips), clipsV);
+
+        stats.min = mins[0];
+        stats.max = maxs[0];
+        stats.clipCount = clips[0];
+
+        for (int lane = 1; lane < 8; ++lane)
+        {
+            stats.min = juce::jmin(stats.min, mins[lane]);
+            stats.max = juce::jmax(stats.max, maxs[lane]);
+            stats.clipCount += clips[lane];
+        }
+
+        analyseScalarRange(data, numVectorised, numSamples, stats);
+        finish(stats, numSamples);
+    }
+   #endif
+
+    //==============================================================================
+    using SumKernel = double (*)(const float*, int);
+
+    double sumScalar(const float* data, int numSamples)
+    {
+        double total = 0.0;
+        for (int i = 0; i < numSamples; ++i)
+            total += data[i];
+        return total;
+    }
+
+   #if JUCE_INTEL
+    double sumSSE(const float* data, int numSamples)
+    {
+        double total = 0.0;
+        const int numVectorised = numSamples & ~3;
+        int i = 0;
+
+        while (i < numVectorised)
+        {
+            auto chunkEnd = juce::jmin(numVectorised, i + flushInterval);
+            auto sumV = _mm_setzero_ps();
+
+            for (; i < chunkEnd; i += 4)
+                sumV = _mm_add_ps(sumV, _mm_loadu_ps(data + i));
+
+            alignas(16) float sums[4];
+            _mm_store_ps(sums, sumV);
+            total += static_cast<double>(sums[0]) + sums[1] + sums[2] + sums[3];
+        }
+
+        return total + sumScalar(data + numVectorised, numSamples - numVectorised);
+    }
+
+    METER_KERNELS_AVX2_TARGET
+    double sumAVX2(const float* data, int numSamples)
+    {
+        double total = 0.0;
+        const int numVectorised = numSamples & ~7;
+        int i = 0;
+
+        while (i < numVectorised)
+        {
+            auto chunkEnd = juce::jmin(numVectorised, i + flushInterval);
+            auto sumV = _mm256_setzero_ps();
+
+            for (; i < chunkEnd; i += 8)
+                sumV = _mm256_add_ps(sumV, _mm256_loadu_ps(data + i));
+
+            alignas(32) float sums[8];
+            _mm256_store_ps(sums, sumV);
+
+            for (int lane = 0; lane < 8; ++lane)
+                total += sums[lane];
+        }
+
+        return total + sumScalar(data + numVectorised, numSamples - numVectorised);
+    }
+   #endif
+
+    //==============================================================================
+    using ProductKernel = WeightedProducts (*)(const float*, const float*, const float*, int);
+
+    void weightedProductsScalarRange(const float* weights, const float* left, const float* right,
+                                     int start, int end, WeightedProducts& products)
+    {
+        for (int i = start; i < end; ++i)
+        {
+            auto weightedLeft = static_cast<double>(weights[i]) * left[i];
+            products.leftRight += weightedLeft * right[i];
+            products.leftLeft += weightedLeft * left[i];
+            products.rightRight += static_cast<double>(weights[i]) * right[i] * right[i];
+        }
+    }
+
+    WeightedProducts weightedProductsScalar(const float* weights, const float* left, const float* right, int numSamples)
+    {
+        WeightedProducts products;
+        weightedProductsScalarRange(weights, left, right, 0, numSamples, products);
+        return products;
+    }
+
+   #if JUCE_INTEL
+    WeightedProducts weightedProductsSSE(const float* weights, const float* left, const float* right, int numSamples)
+    {
+        WeightedProducts products;
+        const int numVectorised = numSamples & ~3;
+        int i = 0;
+
+        while (i < numVectorised)
+        {
+            auto chunkEnd = juce::jmin(numVectorised, i + flushInterval);
+            auto lrV = _mm_setzero_ps(), llV = _mm_setzero_ps(), rrV = _mm_setzero_ps();
+
+            for (; i < chunkEnd; i += 4)
+            {
+                auto w = _mm_loadu_ps(weights + i);
+                auto l = _mm_loadu_ps(left + i);
+                auto r = _mm_loadu_ps(right + i);
+                auto wl = _mm_mul_ps(w, l);
+                lrV = _mm_add_ps(lrV, _mm_mul_ps(wl, r));
+                llV = _mm_add_ps(llV, _mm_mul_ps(wl, l));
+                rrV = _mm_add_ps(rrV, _mm_mul_ps(_mm_mul_ps(w, r), r));
+            }
+
+            alignas(16) float lr[4], ll[4], rr[4];
+            _mm_store_ps(lr, lrV);
+            _mm_store_ps(ll, llV);
+            _mm_store_ps(rr, rrV);
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                products.leftRight += lr[lane];
+                products.leftLeft += ll[lane];
+                products.rightRight += rr[lane];
+            }
+        }
+
+        weightedProductsScalarRange(weights, left, right, numVectorised, numSamples, products);
+        return products;
+    }
+
+    METER_KERNELS_AVX2_TARGET
+    WeightedProducts weightedProductsAVX2(const float* weights, const float* left, const float* right, int numSamples)
+    {
+        WeightedProducts products;
+        const int numVectorised = numSamples & ~7;
+        int i = 0;
+
+        while (i < numVectorised)
+        {
+            auto chunkEnd = juce::jmin(numVectorised, i + flushInterval);
+            auto lrV = _mm256_setzero_ps(), llV = _mm256_setzero_ps(), rrV = _mm256_setzero_ps();
+
+            for (; i < chunkEnd; i += 8)
+            {
+                auto w = _mm256_loadu_ps(weights + i);
+                auto l = _mm256_loadu_ps(left + i);
+                auto r = _mm256_loadu_ps(right + i);
+                auto wl = _mm256_mul_ps(w, l);
+                lrV = _mm256_add_ps(lrV, _mm256_mul_ps(wl, r));
+                llV = _mm256_add_ps(llV, _mm256_mul_ps(wl, l));
+                rrV = _mm256_add_ps(rrV, _mm256_mul_ps(_mm256_mul_ps(w, r), r));
+            }
+
+            alignas(32) float lr[8], ll[8], rr[8];
+            _mm256_store_ps(lr, lrV);
+            _mm256_store_ps(ll, llV);
+            _mm256_store_ps(rr, rrV);
+
+            for (int lane = 0; lane < 8; ++lane)
+            {
+                products.leftRight += lr[lane];
+                products.leftLeft += ll[lane];
+                products.rightRight += rr[lane];
+            }
+        }
+
+        weightedProductsScalarRange(weights, left, right, numVectorised, numSamples, products);
+        return products;
+    }
+   #endif
+
+    //==============================================================================
+    using PowerKernel = void (*)(const float* const*, int, int, const BiquadCoefficients&,
+                                 const BiquadCoefficients&, double*, double*);
+
+    void filteredPowerScalar(const float* const* channels, int numChannels, int numSamples,
+                             const BiquadCoefficients& first, const BiquadCoefficients& second,
+                             double* state, double* sumsOfSquares)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = channels[channel];
+            auto* s = state + channel * 4;
+            auto s1 = s[0], s2 = s[1], s3 = s[2], s4 = s[3];
+            double sumOfSquares = 0.0;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                double x = data[i];
+
+                auto y = first.b0 * x + s1;
+                s1 = first.b1 * x - first.a1 * y + s2;
+                s2 = first.b2 * x - first.a2 * y;
+
+                auto z = second.b0 * y + s3;
+                s3 = second.b1 * y - second.a1 * z + s4;
+                s4 = second.b2 * y - second.a2 * z;
+
+                sumOfSquares += z * z;
+            }
+
+            s[0] = s1; s[1] = s2; s[2] = s3; s[3] = s4;
+            sumsOfSquares[channel] += sumOfSquares;
+        }
+    }
+
+   #if JUCE_INTEL
+    // the recursion is serial in time, so the lanes run side by side across channels
+    void filteredPowerSSE(const float* const* channels, int numChannels, int numSamples,
+                          const BiquadCoefficients& first, const BiquadCoefficients& second,
+                          double* state, double* sumsOfSquares)
+    {
+        const auto fb0 = _mm_set1_pd(first.b0), fb1 = _mm_set1_pd(first.b1), fb2 = _mm_set1_pd(first.b2);
+        const auto fa1 = _mm_set1_pd(first.a1), fa2 = _mm_set1_pd(first.a2);
+        const auto sb0 = _mm_set1_pd(second.b0), sb1 = _mm_set1_pd(second.b1), sb2 = _mm_set1_pd(second.b2);
+        const auto sa1 = _mm_set1_pd(second.a1), sa2 = _mm_set1_pd(second.a2);
+
+        int channel = 0;
+        for (; channel + 2 <= numChannels; channel += 2)
+        {
+            auto* a = channels[channel];
+            auto* b = channels[channel + 1];
+            auto* sa = state + channel * 4;
+            auto* sb = sa + 4;
+
+            auto s1 = _mm_set_pd(sb[0], sa[0]), s2 = _mm_set_pd(sb[1], sa[1]);
+            auto s3 = _mm_set_pd(sb[2], sa[2]), s4 = _mm_set_pd(sb[3], sa[3]);
+            auto sumV = _mm_setzero_pd();
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto x = _mm_set_pd(b[i], a[i]);
+
+                auto y = _mm_add_pd(_mm_mul_pd(fb0, x), s1);
+                s1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(fb1, x), _mm_mul_pd(fa1, y)), s2);
+                s2 = _mm_sub_pd(_mm_mul_pd(fb2, x), _mm_mul_pd(fa2, y));
+
+                auto z = _mm_add_pd(_mm_mul_pd(sb0, y), s3);
+                s3 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(sb1, y), _mm_mul_pd(sa1, z)), s4);
+                s4 = _mm_sub_pd(_mm_mul_pd(sb2, y), _mm_mul_pd(sa2, z));
+
+                sumV = _mm_add_pd(sumV, _mm_mul_pd(z, z));
+            }
+
+            alignas(16) double lanes[2];
+            _mm_store_pd(lanes, s1); sa[0] = lanes[0]; sb[0] = lanes[1];
+            _mm_store_pd(lanes, s2); sa[1] = lanes[0]; sb[1] = lanes[1];
+            _mm_store_pd(lanes, s3); sa[2] = lanes[0]; sb[2] = lanes[1];
+            _mm_store_pd(lanes, s4); sa[3] = lanes[0]; sb[3] = lanes[1];
+            _mm_store_pd(lanes, sumV);
+            sumsOfSquares[channel] += lanes[0];
+            sumsOfSquares[channel + 1] += lanes[1];
+        }
+
+        if (channel < numChannels)
+            filteredPowerScalar(channels + channel, numChannels - channel, numSamples,
+                                first, second, state + channel * 4, sumsOfSquares + channel);
+    }
+
+    METER_KERNELS_AVX2_TARGET
+    void filteredPowerAVX2(const float* const* channels, int numChannels, int numSamples,
+                           const BiquadCoefficients& first, const BiquadCoefficients& second,
+                           double* state, double* sumsOfSquares)
+    {
+        const auto fb0 = _mm256_set1_pd(first.b0), fb1 = _mm256_set1_pd(first.b1), fb2 = _mm256_set1_pd(first.b2);
+        const auto fa1 = _mm256_set1_pd(first.a1), fa2 = _mm256_set1_pd(first.a2);
+        const auto sb0 = _mm256_set1_pd(second.b0), sb1 = _mm256_set1_pd(second.b1), sb2 = _mm256_set1_pd(second.b2);
+        const auto sa1 = _mm256_set1_pd(second.a1), sa2 = _mm256_set1_pd(second.a2);
+
+        int channel = 0;
+        for (; channel + 4 <= numChannels; channel += 4)
+        {
+            auto* c = channels + channel;
+            auto* st = state + channel * 4;
+
+            // lambdas would not inherit the avx2 target, so the lanes are gathered by hand
+            auto s1 = _mm256_set_pd(st[12], st[8], st[4], st[0]);
+            auto s2 = _mm256_set_pd(st[13], st[9], st[5], st[1]);
+            auto s3 = _mm256_set_pd(st[14], st[10], st[6], st[2]);
+            auto s4 = _mm256_set_pd(st[15], st[11], st[7], st[3]);
+            auto sumV = _mm256_setzero_pd();
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto x = _mm256_set_pd(c[3][i], c[2][i], c[1][i], c[0][i]);
+
+                auto y = _mm256_add_pd(_mm256_mul_pd(fb0, x), s1);
+                s1 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(fb1, x), _mm256_mul_pd(fa1, y)), s2);
+                s2 = _mm256_sub_pd(_mm256_mul_pd(fb2, x), _mm256_mul_pd(fa2, y));
+
+                auto z = _mm256_add_pd(_mm256_mul_pd(sb0, y), s3);
+                s3 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(sb1, y), _mm256_mul_pd(sa1, z)), s4);
+                s4 = _mm256_sub_pd(_mm256_mul_pd(sb2, y), _mm256_mul_pd(sa2, z));
+
+                sumV = _mm256_add_pd(sumV, _mm256_mul_pd(z, z));
+            }
+
+            alignas(32) double lanes[4][4];
+            _mm256_store_pd(lanes[0], s1);
+            _mm256_store_pd(lanes[1], s2);
+            _mm256_store_pd(lanes[2], s3);
+            _mm256_store_pd(lanes[3], s4);
+
+            for (int lane = 0; lane < 4; ++lane)
+                for (int k = 0; k < 4; ++k)
+                    st[lane * 4 + k] = lanes[k][lane];
+
+            _mm256_store_pd(lanes[0], sumV);
+            for (int lane = 0; lane < 4; ++lane)
+                sumsOfSquares[channel + lane] += lanes[0][lane];
+        }
+
+        if (channel < numChannels)
+            filteredPowerSSE(channels + channel, numChannels - channel, numSamples,
+                             first, second, state + channel * 4, sumsOfSquares + channel);
+    }
+   #endif
+
+    //==============================================================================
+    using TruePeakKernel = TruePeakStats (*)(const float*, int, float);
+
+    // ITU-R BS.1770-4 Annex 2 interpolator, [tap][phase]
+    alignas(32) const float truePeakCoefficients[MeterKernels::truePeakTaps][4] =
+    {
+        { 0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+        { 0.0109863281250f, 0.0292968750000f, 0.0330810546875f, 0.0148925781250f },
+        { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+        { 0.0332031250000f, 0.0891113281250f, 0.1015625000000f, 0.0476074218750f },
+        { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+        { 0.1373291015625f, 0.4650878906250f, 0.7797851562500f, 0.9721679687500f },
+        { 0.9721679687500f, 0.7797851562500f, 0.4650878906250f, 0.1373291015625f },
+        { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+        { 0.0476074218750f, 0.1015625000000f, 0.0891113281250f, 0.0332031250000f },
+        { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+        { 0.0148925781250f, 0.0330810546875f, 0.0292968750000f, 0.0109863281250f },
+        { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f, 0.0017089843750f },
+    };
+
+    TruePeakStats truePeakScalarRange(const float* data, int start, int end, float overLevel, TruePeakStats stats)
+    {
+        for (int n = start; n < end; ++n)
+        {
+            float samplePeak = 0.0f;
+            for (int phase = 0; phase < 4; ++phase)
+            {
+                float y = 0.0f;
+                for (int k = 0; k < MeterKernels::truePeakTaps; ++k)
+                    y += truePeakCoefficients[k][phase] * data[n - k];
+
+                samplePeak = juce::jmax(samplePeak, std::abs(y));
+            }
+
+            stats.peak = juce::jmax(stats.peak, samplePeak);
+            stats.numOvers += samplePeak >= overLevel ? 1 : 0;
+        }
+
+        return stats;
+    }
+
+    TruePeakStats truePeakScalar(const float* data, int numSamples, float overLevel)
+    {
+        return truePeakScalarRange(data, 0, numSamples, overLevel, {});
+    }
+
+   #if JUCE_INTEL
+    TruePeakStats truePeakSSE(const float* data, int numSamples, float overLevel)
+    {
+        const auto absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const auto level = _mm_set1_ps(overLevel);
+
+        __m128 coefficients[MeterKernels::truePeakTaps];
+        for (int k = 0; k < MeterKernels::truePeakTaps; ++k)
+            coefficients[k] = _mm_load_ps(truePeakCoefficients[k]);
+
+        TruePeakStats stats;
+        auto peakV = _mm_setzero_ps();
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            // the four phases of one input sample side by side
+            auto y = _mm_mul_ps(coefficients[0], _mm_set1_ps(data[n]));
+            for (int k = 1; k < MeterKernels::truePeakTaps; ++k)
+                y = _mm_add_ps(y, _mm_mul_ps(coefficients[k], _mm_set1_ps(data[n - k])));
+
+            y = _mm_and_ps(y, absMask);
+            peakV = _mm_max_ps(peakV, y);
+            stats.numOvers += _mm_movemask_ps(_mm_cmpge_ps(y, level)) != 0 ? 1 : 0;
+        }
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, peakV);
+        stats.peak = juce::jmax(lanes[0], lanes[1], lanes[2], lanes[3]);
+        return stats;
+    }
+
+    METER_KERNELS_AVX2_TARGET
+    TruePeakStats truePeakAVX2(const float* data, int numSamples, float overLevel)
+    {
+        const auto absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        const auto level = _mm256_set1_ps(overLevel);
+
+        __m256 coefficients[MeterKernels::truePeakTaps];
+        for (int k = 0; k < MeterKernels::truePeakTaps; ++k)
+            coefficients[k] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(truePeakCoefficients[k]));
+
+        TruePeakStats stats;
+        auto peakV = _mm256_setzero_ps();
+        const int numVectorised = numSamples & ~1;
+
+        for (int n = 0; n < numVectorised; n += 2)
+        {
+            // phases of sample n in the low half, of sample n + 1 in the high half
+            auto y = _mm256_setzero_ps();
+            for (int k = 0; k < MeterKernels::truePeakTaps; ++k)
+            {
+                auto x = _mm256_set_ps(data[n + 1 - k], data[n + 1 - k], data[n + 1 - k], data[n + 1 - k],
+                                       data[n - k], data[n - k], data[n - k], data[n - k]);
+                y = _mm256_add_ps(y, _mm256_mul_ps(coefficients[k], x));
+            }
+
+            y = _mm256_and_ps(y, absMask);
+            peakV = _mm256_max_ps(peakV, y);
+
+            auto overs = _mm256_movemask_ps(_mm256_cmp_ps(y, level, _CMP_GE_OQ));
+            stats.numOvers += ((overs & 0x0f) != 0 ? 1 : 0) + ((overs & 0xf0) != 0 ? 1 : 0);
+        }
+
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, peakV);
+        for (auto lane : lanes)
+            stats.peak = juce::jmax(stats.peak, lane);
+
+        return truePeakScalarRange(data, numVectorised, numSamples, overLevel, stats);
+    }
+   #endif
+
+    //==============================================================================
+    ChannelKernel getKernel(MeterKernels::Implementation implementation)
+    {
+        switch (implementation)
+        {
+           #if JUCE_INTEL
+            case MeterKernels::Implementation::AVX2: return analyseAVX2;
+            case MeterKernels::Implementation::SSE: return analyseSSE;
+           #endif
+            default: return analyseScalar;
+        }
+    }
+
+    // resolved once during static initialisation so the audio thread never
+    // has to query the CPU
+    const MeterKernels::Implementation bestImplementation = []
+    {
+       #if JUCE_INTEL
+        if (juce::SystemStats::hasAVX2())
+            return MeterKernels::Implementation::AVX2;
+        if (juce::SystemStats::hasSSE2())
+            return MeterKernels::Implementation::SSE;
+       #endif
+        return MeterKernels::Implementation::Scalar;
+    }();
+
+    ProductKernel getProductKernel(MeterKernels::Implementation implementation)
+    {
+        switch (implementation)
+        {
+           #if JUCE_INTEL
+            case MeterKernels::Implementation::AVX2: return weightedProductsAVX2;
+            case MeterKernels::Implementation::SSE: return weightedProductsSSE;
+           #endif
+            default: return weightedProductsScalar;
+        }
+    }
+
+    SumKernel getSumKernel(MeterKernels::Implementation implementation)
+    {
+        switch (implementation)
+        {
+           #if JUCE_INTEL
+            case MeterKernels::Implementation::AVX2: return sumAVX2;
+            case MeterKernels::Implementation::SSE: return sumSSE;
+           #endif
+            default: return sumScalar;
+        }
+    }
+
+    PowerKernel getPowerKernel(MeterKernels::Implementation implementation)
+    {
+        switch (implementation)
+        {
+           #if JUCE_INTEL
+            case MeterKernels::Implementation::AVX2: return filteredPowerAVX2;
+            case MeterKernels::Implementation::SSE: return filteredPowerSSE;
+           #endif
+            default: return filteredPowerScalar;
+        }
+    }
+
+    TruePeakKernel getTruePeakKernel(MeterKernels::Implementation implementation)
+    {
+        switch (implementation)
+        {
+           #if JUCE_INTEL
+            case MeterKernels::Implementation::AVX2: return truePeakAVX2;
+            case MeterKernels::Implementation::SSE: return truePeakSSE;
+           #endif
+            default: return truePeakScalar;
+        }
+    }
+
+    const ChannelKernel bestKernel = getKernel(bestImplementation);
+    const SumKernel bestSumKernel = getSumKernel(bestImplementation);
+    const ProductKernel bestProductKernel = getProductKernel(bestImplementation);
+    const PowerKernel bestPowerKernel = getPowerKernel(bestImplementation);
+    const TruePeakKernel bestTruePeakKernel = getTruePeakKernel(bestImplementation);
+}
+//==============================================================================
+void MeterKernels::analyse(const float* const* channels, int numChannels, int numSamples,
+                           ChannelStats* results, Implementation implementation)
+{
+    jassert(implementation == Implementation::Automatic || isSupported(implementation));
+
+    auto kernel = implementation == Implementation::Automatic ? bestKernel : getKernel(implementation);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        kernel(channels[channel], numSamples, results[channel]);
+}
+
+double MeterKernels::sum(const float* data, int numSamples, Implementation implementation)
+{
+    jassert(implementation == Implementation::Automatic || isSupported(implementation));
+
+    auto kernel = implementation == Implementation::Automatic ? bestSumKernel : getSumKernel(implementation);
+    return kernel(data, numSamples);
+}
+
+WeightedProducts MeterKernels::weightedProducts(const float* weights, const float* left, const float* right, int numSamples,
+                                               Implementation implementation)
+{
+    jassert(implementation == Implementation::Automatic || isSupported(implementation));
+
+    auto kernel = implementation == Implementation::Automatic ? bestProductKernel : getProductKernel(implementation);
+    return kernel(weights, left, right, numSamples);
+}
+
+void MeterKernels::filteredPower(const float* const* channels, int numChannels, int numSamples,
+                                 const BiquadCoefficients& first, const BiquadCoefficients& second,
+                                 double* state, double* sumsOfSquares, Implementation implementation)
+{
+    jassert(implementation == Implementation::Automatic || isSupported(implementation));
+
+    auto kernel = implementation == Implementation::Automatic ? bestPowerKernel : getPowerKernel(implementation);
+    kernel(channels, numChannels, numSamples, first, second, state, sumsOfSquares);
+}
+
+TruePeakStats MeterKernels::truePeak(const float* data, int numSamples, float overLevel, Implementation implementation)
+{
+    jassert(implementation == Implementation::Automatic || isSupported(implementation));
+
+    auto kernel = implementation == Implementation::Automatic ? bestTruePeakKernel : getTruePeakKernel(implementation);
+    return kernel(data, numSamples, overLevel);
+}
+
+MeterKernels::Implementation MeterKernels::getBestImplementation() { return bestImplementation; }
+
+bool MeterKernels::isSupported(Implementation implementation)
+{
+    switch (implementation)
+    {
+       #if JUCE_INTEL
+        case Implementation::AVX2: return juce::SystemStats::hasAVX2();
+        case Implementation::SSE: return juce::SystemStats::hasSSE2();
+       #else
+        case Implementation::AVX2:
+        case Implementation::SSE: return false;
+       #endif
+        default: return true;
+    }
+}
+
+juce::String MeterKernels::getName(Implementation implementation)
+{
+    switch (implementation)
+    {
+        case Implementation::Scalar: return "scalar";
+        case Implementation::SSE: return "sse";
+        case Implementation::AVX2: return "avx2";
+        default: return getName(getBestImplementation());
+    }
+}
+//==============================================================================
+void CorrelationEngine::prepare(double sampleRate, double timeConstantMs)
+{
+    auto coefficient = std::exp(-1000.0 / (timeConstantMs * sampleRate));
+
+    decayPowers[0] = 1.0;
+    for (int n = 1; n <= chunkSize; ++n)
+        decayPowers[n] = decayPowers[n - 1] * coefficient;
+
+    for (int i = 0; i < chunkSize; ++i)
+        weights[i] = static_cast<float>(decayPowers[chunkSize - 1 - i]);
+
+    reset();
+}
+
+void CorrelationEngine::reset()
+{
+    productLR = powerL = powerR = 0.0;
+}
+
+void CorrelationEngine::process(const float* left, const float* right, int numSamples)
+{
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        auto num = juce::jmin(chunkSize, numSamples - start);
+
+        // the last num weights are a^(num-1) ... a^0
+        auto products = MeterKernels::weightedProducts(weights.data() + chunkSize - num, left + start, right + start, num);
+        auto decay = decayPowers[num];
+
+        // the (1 - a) input gain cancels out in the correlation ratio
+        productLR = productLR * decay + products.leftRight;
+        powerL = powerL * decay + products.leftLeft;
+        powerR = powerR * decay + products.rightRight;
+    }
+
+    // keep silence from decaying into denormals
+    if (powerL < 1.0e-30 || powerR < 1.0e-30)
+        productLR = powerL = powerR = 0.0;
+}
+
+float CorrelationEngine::getCorrelation() const
+{
+    auto denominator = std::sqrt(powerL * powerR);
+    if (denominator <= 0.0)
+        return 0.0f;
+
+    return static_cast<float>(juce::jlimit(-1.0, 1.0, productLR / denominator));
+}
+//==============================================================================
+void TruePeakDetector::prepare(int numChannels)
+{
+    history.assign(numChannels * historyLength, 0.0f);
+}
+
+void TruePeakDetector::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+}
+
+TruePeakStats TruePeakDetector::process(int channel, const float* data, int numSamples, float overLevel)
+{
+    jassert(channel * historyLength < static_cast<int>(history.size()));
+
+    auto* channelHistory = history.data() + channel * historyLength;
+    TruePeakStats stats;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        auto num = juce::jmin(chunkSize, numSamples - start);
+
+        // the kernel reads behind the block, so it runs on a copy that is
+        // preceded by the end of the previous one
+        std::copy(channelHistory, channelHistory + historyLength, scratch.begin());
+        std::copy(data + start, data + start + num, scratch.begin() + historyLength);
+
+        auto chunkStats = MeterKernels::truePeak(scratch.data() + historyLength, num, overLevel);
+        stats.peak = juce::jmax(stats.peak, chunkStats.peak);
+        stats.numOvers += chunkStats.numOvers;
+
+        std::copy(scratch.begin() + num, scratch.begin() + num + historyLength, channelHistory);
+    }
+
+    return stats;
+}
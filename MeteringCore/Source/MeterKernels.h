@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    MeterKernels.h
+    Fused single-pass level analysis, block correlation, filtered power and
+    true peak with SSE/AVX2 paths and a scalar fallback.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+struct ChannelStats
+{
+    float min{ 0.0f };
+    float max{ 0.0f };
+    float absMax{ 0.0f };
+    double sumOfSquares{ 0.0 };
+    double sum{ 0.0 };
+    int clipCount{ 0 };
+};
+//==============================================================================
+struct WeightedProducts
+{
+    double leftRight{ 0.0 };
+    double leftLeft{ 0.0 };
+    double rightRight{ 0.0 };
+};
+//==============================================================================
+struct TruePeakStats
+{
+    float peak{ 0.0f };
+    int numOvers{ 0 };
+};
+//==============================================================================
+/** Normalised biquad coefficients, a0 == 1. */
+struct BiquadCoefficients
+{
+    double b0{ 1.0 }, b1{ 0.0 }, b2{ 0.0 };
+    double a1{ 0.0 }, a2{ 0.0 };
+};
+//==============================================================================
+namespace MeterKernels
+{
+    enum class Implementation { Automatic, Scalar, SSE, AVX2 };
+
+    /** Samples at or above this magnitude are counted as clipped. */
+    constexpr float clipLevel = 1.0f;
+
+    /** Fills one ChannelStats per channel with a single pass over each channel.
+        Automatic uses the fastest implementation the CPU supports, picked once
+        at startup, so this is safe to call from the audio thread.
+    */
+    void analyse(const float* const* channels, int numChannels, int numSamples,
+                 ChannelStats* results, Implementation implementation = Implementation::Automatic);
+
+    /** Sum of numSamples values, accumulated in double precision. */
+    double sum(const float* data, int numSamples, Implementation implementation = Implementation::Automatic);
+
+    /** Sums weights[i] * L[i] * R[i], weights[i] * L[i]^2 and weights[i] * R[i]^2
+        in one pass.
+    */
+    WeightedProducts weightedProducts(const float* weights, const float* left, const float* right, int numSamples,
+                                      Implementation implementation = Implementation::Automatic);
+
+    /** Runs every channel through two cascaded biquads and adds the sum of squares
+        of the result to sumsOfSquares[channel]; the filtered signal itself is never
+        stored. state holds four doubles per channel and carries the transposed
+        direct form II state between calls. The vector paths filter two (SSE) or
+        four (AVX2) channels at once in double precision.
+    */
+    void filteredPower(const float* const* channels, int numChannels, int numSamples,
+                       const BiquadCoefficients& first, const BiquadCoefficients& second,
+                       double* state, double* sumsOfSquares,
+                       Implementation implementation = Implementation::Automatic);
+
+    /** Taps per phase of the BS.1770 4x interpolator. */
+    constexpr int truePeakTaps = 12;
+
+    /** Absolute peak of data after 4x oversampling with the BS.1770 polyphase
+        interpolator, and the number of input samples whose interpolated peak
+        reaches overLevel. data[-(truePeakTaps - 1)] ... data[-1] must hold the
+        samples preceding the block. The vector paths compute all four phases
+        of one (SSE) or two (AVX2) input samples per step.
+    */
+    TruePeakStats truePeak(const float* data, int numSamples, float overLevel,
+                           Implementation implementation = Implementation::Automatic);
+
+    /** The implementation Automatic resolves to on this machine. */
+    Implementation getBestImplementation();
+
+    bool isSupported(Implementation implementation);
+
+    juce::String getName(Implementation implementation);
+}
+//==============================================================================
+/**
+    Correlation of two channels from one-pole integrated cross and auto products.
+    A whole block is integrated at once: the state decays by a^n and the new
+    products are added with the weights a^(n-1-k), which turns the recursion
+    into three SIMD dot products. State is kept in double precision.
+*/
+struct CorrelationEngine
+{
+    void prepare(double sampleRate, double timeConstantMs);
+    void reset();
+    void process(const float* left, const float* right, int numSamples);
+    /** -1 ... +1, 0 while either channel is silent */
+    float getCorrelation() const;
+
+    static constexpr int chunkSize = 512;
+
+private:
+    // weights[i] = a^(chunkSize - 1 - i), decayPowers[n] = a^n
+    std::array<float, chunkSize> weights;
+    std::array<double, chunkSize + 1> decayPowers;
+
+    double productLR{ 0.0 }, powerL{ 0.0 }, powerR{ 0.0 };
+};
+//==============================================================================
+/**
+    Per-channel true peak of consecutive blocks. Each channel keeps the last
+    few samples of its previous block as interpolator history; all storage is
+    allocated in prepare().
+*/
+struct TruePeakDetector
+{
+    void prepare(int numChannels);
+    void reset();
+    TruePeakStats process(int channel, const float* data, int numSamples, float overLevel);
+
+private:
+    static constexpr int historyLength = MeterKernels::truePeakTaps - 1;
+    static constexpr int chunkSize = 256;
+
+    std::vector<float> history;     // historyLength per channel
+    std::array<float, historyLength + chunkSize> scratch;
+};
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    SpectrumEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumEngine.h"
+
+//==============================================================================
+void SpectrumEngine::prepare(double newSampleRate, int fftOrder, int overlap)
+{
+    sampleRate = newSampleRate;
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+    fftSize = fft->getSize();
+    hopSize = fftSize / juce::jlimit(1, 8, overlap);
+
+    window.resize(fftSize);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), static_cast<size_t>(fftSize),
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+
+    // a full-scale sine peaks at half the sum of the window
+    auto windowSum = std::accumulate(window.begin(), window.end(), 0.0f);
+    magnitudeScale = 2.0f / windowSum;
+
+    history.resize(fftSize);
+    fftData.resize(2 * fftSize);
+
+    setReleaseRate(releaseDbPerSecond);
+    reset();
+}
+
+void SpectrumEngine::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    writeIndex = 0;
+    samplesUntilFrame = hopSize;
+    levels.fill(floorDb);
+}
+
+void SpectrumEngine::setColumns(int newNumColumns, float minHz, float maxHz)
+{
+    jassert(fftSize > 0);
+    numColumns = juce::jlimit(0, maxColumns, newNumColumns);
+
+    auto binWidth = sampleRate / fftSize;
+    auto lastUsableBin = fftSize / 2 - 1;
+    auto logRange = std::log(maxHz / minHz);
+
+    auto toBin = [&](double hz) { return juce::jlimit(1, lastUsableBin, static_cast<int>(hz / binWidth)); };
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        auto lowHz = minHz * std::exp(logRange * column / numColumns);
+        auto highHz = minHz * std::exp(logRange * (column + 1) / numColumns);
+
+        // at the low end a column is narrower than a bin and gets the bin it sits in
+        firstBin[column] = toBin(lowHz);
+        lastBin[column] = juce::jmax(firstBin[column], toBin(highHz) - 1);
+    }
+
+    levels.fill(floorDb);
+}
+
+void SpectrumEngine::setReleaseRate(float dbPerSecond)
+{
+    releaseDbPerSecond = dbPerSecond;
+    releasePerFrame = hopSize > 0 ? static_cast<float>(dbPerSecond * hopSize / sampleRate) : 0.0f;
+}
+
+bool SpectrumEngine::process(const float* const* channels, int numChannels, int numSamples)
+{
+    if (fftSize == 0 || numChannels == 0)
+        return false;
+
+    auto channelGain = 1.0f / numChannels;
+    bool hasNewFrame = false;
+
+    for (int start = 0; start < numSamples;)
+    {
+        // up to the next frame or the end of the ring, whichever comes first
+        auto num = juce::jmin(numSamples - start, samplesUntilFrame, fftSize - writeIndex);
+        auto* destination = history.data() + writeIndex;
+
+        juce::FloatVectorOperations::copyWithMultiply(destination, channels[0] + start, channelGain, num);
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply(destination, channels[channel] + start, channelGain, num);
+
+        start += num;
+        writeIndex = (writeIndex + num) % fftSize;
+        samplesUntilFrame -= num;
+
+        if (samplesUntilFrame == 0)
+        {
+            analyseFrame();
+            samplesUntilFrame = hopSize;
+            hasNewFrame = true;
+        }
+    }
+
+    return hasNewFrame;
+}
+
+void SpectrumEngine::analyseFrame()
+{
+    // oldest sample first
+    auto numOldest = fftSize - writeIndex;
+    juce::FloatVectorOperations::multiply(fftData.data(), history.data() + writeIndex, window.data(), numOldest);
+    juce::FloatVectorOperations::multiply(fftData.data() + numOldest, history.data(), window.data() + numOldest, writeIndex);
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+
+    fft->performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    // only one dB conversion per column, not per bin
+    for (int column = 0; column < numColumns; ++column)
+    {
+        auto* first = fftData.data() + firstBin[column];
+        auto peak = *std::max_element(first, fftData.data() + lastBin[column] + 1);
+
+        auto db = juce::Decibels::gainToDecibels(peak * magnitudeScale, floorDb);
+        levels[column] = juce::jmax(db, levels[column] - releasePerFrame);
+    }
+}
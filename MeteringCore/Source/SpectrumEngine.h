@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    SpectrumEngine.h
+    Overlapped, windowed FFT frames reduced to log-spaced display columns.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Averages all channels into one analysis signal and runs a Hann-windowed
+    FFT every hop. Each display column covers a fixed range of bins, worked
+    out once in setColumns(), and shows the loudest bin of that range so
+    narrow peaks survive however many bins share a pixel.
+    Everything is allocated in prepare(), process() and setColumns() can run
+    on a worker thread without touching the heap.
+*/
+struct SpectrumEngine
+{
+    static constexpr int maxColumns = 2048;
+    static constexpr float floorDb = -120.0f;
+
+    /** overlap is the number of frames per FFT length: 2 for 50%, 4 for 75%. */
+    void prepare(double sampleRate, int fftOrder, int overlap);
+    void reset();
+
+    /** Maps the bins onto numColumns log-spaced columns from minHz to maxHz. */
+    void setColumns(int numColumns, float minHz, float maxHz);
+    /** Falling columns drop by at most this much per second. */
+    void setReleaseRate(float dbPerSecond);
+
+    /** Returns true if at least one new frame was analysed. */
+    bool process(const float* const* channels, int numChannels, int numSamples);
+
+    int getNumColumns() const { return numColumns; }
+    /** dB relative to a full-scale sine, floorDb for silence. */
+    const float* getColumnLevels() const { return levels.data(); }
+
+private:
+    void analyseFrame();
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    double sampleRate{ 48000.0 };
+    int fftSize{ 0 }, hopSize{ 0 };
+
+    std::vector<float> window;
+    std::vector<float> history;     // the last fftSize samples, a ring
+    std::vector<float> fftData;     // 2 * fftSize, as the FFT wants it
+    int writeIndex{ 0 };
+    int samplesUntilFrame{ 0 };
+
+    // column c shows the loudest of the bins firstBin[c] ... lastBin[c]
+    int numColumns{ 0 };
+    std::array<int, maxColumns> firstBin, lastBin;
+    std::array<float, maxColumns> levels;
+
+    float releaseDbPerSecond{ 60.0f };
+    float releasePerFrame{ 0.0f };
+    float magnitudeScale{ 1.0f };
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.h
+    Fixed set of worker threads, each with its own job deques. A worker runs
+    its own jobs newest first and, once it runs dry, steals the oldest job
+    from another worker, so uneven jobs still keep every core busy.
+    High priority jobs are always taken before low priority ones, by the
+    owner and by thieves.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+//==============================================================================
+class WorkStealingPool
+{
+public:
+    using Job = std::function<void()>;
+    enum class Priority { High, Low };
+
+    explicit WorkStealingPool(int numWorkers = juce::SystemStats::getNumCpus())
+    {
+        for (int i = 0; i < juce::jmax(1, numWorkers); ++i)
+            workers.push_back(std::make_unique<Worker>());
+
+        for (int i = 0; i < static_cast<int>(workers.size()); ++i)
+            workers[i]->thread = std::thread([this, i] { runWorker(i); });
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> sleeping(sleepLock);
+            shouldQuit = true;
+        }
+        wakeUp.notify_all();
+
+        for (auto& worker : workers)
+            worker->thread.join();
+    }
+
+    int getNumWorkers() const { return static_cast<int>(workers.size()); }
+
+    /** Queues a job, spreading jobs round-robin over the workers. Any thread. */
+    void submit(Job job, Priority priority = Priority::High)
+    {
+        auto& worker = *workers[nextWorker++ % workers.size()];
+        {
+            std::lock_guard<std::mutex> queue(worker.lock);
+            worker.jobs[static_cast<int>(priority)].push_back(std::move(job));
+        }
+
+        ++numUnfinished;
+        {
+            std::lock_guard<std::mutex> sleeping(sleepLock);
+            ++numQueued;
+        }
+        wakeUp.notify_one();
+    }
+
+    /** Blocks until every submitted job has finished. */
+    void waitForAll()
+    {
+        std::unique_lock<std::mutex> sleeping(sleepLock);
+        allDone.wait(sleeping, [this] { return numUnfinished.load() == 0; });
+    }
+
+private:
+    static constexpr int numPriorities = 2;
+
+    struct Worker
+    {
+        std::mutex lock;
+        std::array<std::deque<Job>, numPriorities> jobs;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> nextWorker{ 0 };
+    std::atomic<int> numUnfinished{ 0 };
+
+    std::mutex sleepLock;
+    std::condition_variable wakeUp, allDone;
+    int numQueued{ 0 };     // guarded by sleepLock
+    bool shouldQuit{ false };
+
+    bool popOwn(int index, int priority, Job& job)
+    {
+        auto& worker = *workers[index];
+        std::lock_guard<std::mutex> queue(worker.lock);
+        auto& jobs = worker.jobs[priority];
+        if (jobs.empty())
+            return false;
+
+        job = std::move(jobs.back());
+        jobs.pop_back();
+        return true;
+    }
+
+    bool steal(int thief, int priority, Job& job)
+    {
+        auto numWorkers = static_cast<int>(workers.size());
+        for (int offset = 1; offset < numWorkers; ++offset)
+        {
+            auto& victim = *workers[(thief + offset) % numWorkers];
+            std::lock_guard<std::mutex> queue(victim.lock);
+            auto& jobs = victim.jobs[priority];
+            if (jobs.empty())
+                continue;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            return true;
+        }
+
+        return false;
+    }
+
+    bool findJob(int index, Job& job)
+    {
+        for (int priority = 0; priority < numPriorities; ++priority)
+            if (popOwn(index, priority, job) || steal(index, priority, job))
+                return true;
+
+        return false;
+    }
+
+    void runWorker(int index)
+    {
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> sleeping(sleepLock);
+                wakeUp.wait(sleeping, [this] { return numQueued > 0 || shouldQuit; });
+
+                if (numQueued == 0)
+                    return;
+
+                // claimed before searching, so a queued job is always found by someone
+                --numQueued;
+            }
+
+            Job job;
+            while (!findJob(index, job))
+                std::this_thread::yield();
+
+            job();
+
+            if (--numUnfinished == 0)
+            {
+                std::lock_guard<std::mutex> sleeping(sleepLock);
+                allDone.notify_all();
+            }
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(WorkStealingPool)
+};
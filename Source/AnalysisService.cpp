@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    AnalysisService.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalysisService.h"
+
+//==============================================================================
+// one core is left for the audio and message threads
+AnalysisService::AnalysisService() :
+    juce::Thread("Meter Analysis"),
+    pool(juce::jlimit(1, 8, juce::SystemStats::getNumCpus() - 1))
+{
+    startThread();
+}
+
+AnalysisService::~AnalysisService()
+{
+    stopThread(1000);
+    pool.waitForAll();
+}
+
+void AnalysisService::add(Client& client)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->client = &client;
+
+    std::lock_guard<std::mutex> lock(clientsLock);
+    clients.push_back(std::move(entry));
+}
+
+void AnalysisService::remove(Client& client)
+{
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(clientsLock);
+        auto found = std::find_if(clients.begin(), clients.end(), [&](auto& e) { return e->client == &client; });
+        if (found == clients.end())
+            return;
+
+        entry = *found;
+        clients.erase(found);
+    }
+
+    // a queued job still holds the entry, it finds the client gone
+    std::lock_guard<std::mutex> analysing(entry->lock);
+    entry->client = nullptr;
+}
+
+void AnalysisService::run()
+{
+    while (!threadShouldExit())
+    {
+        tick();
+        wait(getTickIntervalMs());
+    }
+}
+
+void AnalysisService::tick()
+{
+    auto analyseHidden = ++tickCount % hiddenTickInterval == 0;
+
+    std::lock_guard<std::mutex> lock(clientsLock);
+    for (auto& entry : clients)
+    {
+        auto visible = entry->client->isVisible();
+        if (!visible && !analyseHidden)
+            continue;
+
+        // still busy with the previous tick's job
+        if (entry->queued.exchange(true))
+            continue;
+
+        pool.submit([entry]
+        {
+            {
+                std::lock_guard<std::mutex> analysing(entry->lock);
+                if (entry->client != nullptr)
+                    entry->client->analyse();
+            }
+            entry->queued.store(false);
+        }, visible ? WorkStealingPool::Priority::High : WorkStealingPool::Priority::Low);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    AnalysisService.h
+    One analysis scheduler and worker pool shared by every plugin instance
+    in the process.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Held through juce::SharedResourcePointer, so all instances loaded into one
+    host share a scheduler thread and a bounded WorkStealingPool. Twice per
+    frame the scheduler queues one job per visible client at high priority;
+    clients without an editor only get a low priority job every few ticks.
+    A client never has more than one job queued or running, so analyse()
+    needs no locking of its own.
+*/
+struct AnalysisService : private juce::Thread
+{
+    struct Client
+    {
+        virtual ~Client() = default;
+        /** Worker thread. Drains the client's FIFOs and publishes results. */
+        virtual void analyse() = 0;
+        /** Any thread. Hidden clients are analysed less often and more cheaply. */
+        virtual bool isVisible() const = 0;
+    };
+
+    AnalysisService();
+    ~AnalysisService() override;
+
+    void add(Client& client);
+    /** Waits for a running job of the client to finish, it is never called again afterwards. */
+    void remove(Client& client);
+
+    int getNumWorkers() const { return pool.getNumWorkers(); }
+    /** Twice per frame, so results are never more than half a frame old. */
+    static int getTickIntervalMs() { return 500 / ValueHolderBase::frameRate; }
+
+private:
+    struct Entry
+    {
+        std::mutex lock;            // held while the client is analysed
+        Client* client{ nullptr };
+        std::atomic<bool> queued{ false };
+    };
+
+    // hidden clients are analysed at 1/8 of the tick rate, which still drains
+    // their FIFOs long before they overflow
+    static constexpr int hiddenTickInterval = 8;
+
+    void run() override;
+    void tick();
+
+    WorkStealingPool pool;
+    std::mutex clientsLock;
+    std::vector<std::shared_ptr<Entry>> clients;
+    int tickCount{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(AnalysisService)
+};
@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+    MeterAnalyser.cpp
+
+  ==============================================================================
+*/
+
+#include "MeterAnalyser.h"
+
+namespace
+{
+    float toDb(float gain)
+    {
+        return juce::jlimit(NEGATIVE_INFINITY, MAX_DECIBELS, juce::Decibels::gainToDecibels(gain, NEGATIVE_INFINITY));
+    }
+}
+//==============================================================================
+MeterAnalyser::MeterAnalyser(juce::AudioProcessor& processor, Fifo<MeterRecord, 512>& recordFifo, SampleFifo<float>& sampleFifo) :
+    audioProcessor(processor),
+    meterRecordFifo(recordFifo),
+    audioBufferFifo(sampleFifo)
+{
+    service->add(*this);
+}
+
+MeterAnalyser::~MeterAnalyser() { service->remove(*this); }
+
+bool MeterAnalyser::pullResults()
+{
+    if (!snapshots.update())
+        return false;
+
+    acknowledgedSequence.store(snapshots.getReadBuffer().sequence);
+    return true;
+}
+
+const AnalysisResults& MeterAnalyser::getResults() const { return snapshots.getReadBuffer(); }
+
+juce::uint32 MeterAnalyser::getMillisecondsSinceLastDrain() const
+{
+    return juce::Time::getMillisecondCounter() - lastDrainTime.load();
+}
+
+void MeterAnalyser::setDistributionMode(int newMode) { distributionMode.store(newMode); }
+
+void MeterAnalyser::resetDistributions() { distributionResetPending.store(true); }
+
+void MeterAnalyser::resetTruePeakHold() { truePeakResetPending.store(true); }
+
+void MeterAnalyser::setSpectrumColumns(int numColumns) { requestedSpectrumColumns.store(numColumns); }
+
+void MeterAnalyser::applyDistributionMode(double sampleRate)
+{
+    // taken once, so a reset requested during the pass waits for the next one
+    auto resetRequested = distributionResetPending.exchange(false);
+
+    // weights are in samples
+    for (auto* distribution : { &peakDistribution, &rmsDistribution })
+    {
+        switch (distributionMode.load())
+        {
+            case Decay: distribution->setDecay(10.0 * sampleRate); break;
+            case Window: distribution->setWindow(30.0 * sampleRate); break;
+            default: distribution->setSession(); break;
+        }
+
+        if (resetRequested)
+            distribution->clear();
+    }
+}
+
+void MeterAnalyser::copyDistribution(const Distribution& source, AnalysisResults::Distribution& dest)
+{
+    source.getFractions(dest.fractions);
+    dest.p10 = source.getPercentile(0.10f);
+    dest.p50 = source.getPercentile(0.50f);
+    dest.p95 = source.getPercentile(0.95f);
+}
+
+void MeterAnalyser::prepareEngines(double sampleRate)
+{
+    preparedSampleRate = sampleRate;
+    slowEngine.prepare(sampleRate, 300.0);
+    peakEngine.prepare(sampleRate, 50.0);
+
+    auto historySize = static_cast<size_t>(sampleRate * GONIOMETER_HISTORY_MS / 1000.0);
+    goniometerHistory.resize(juce::jlimit<size_t>(1, AnalysisResults::maxGoniometerPoints, historySize), {});
+
+    // 4096 points with 75% overlap
+    spectrum.prepare(sampleRate, 12, 4);
+    spectrum.setColumns(requestedSpectrumColumns.load(), SPECTRUM_MIN_HZ, SPECTRUM_MAX_HZ);
+}
+
+void MeterAnalyser::copyGoniometerHistory()
+{
+    auto& data = goniometerHistory.getData();
+    auto oldest = data.begin() + static_cast<std::ptrdiff_t>(goniometerHistory.getReadIndex());
+    auto destination = std::copy(oldest, data.end(), results.goniometerPoints.begin());
+    std::copy(data.begin(), oldest, destination);
+    results.numGoniometerPoints = static_cast<int>(data.size());
+}
+
+void MeterAnalyser::analyse()
+{
+    std::unique_lock<std::mutex> fifosReady(fifoLock, std::try_to_lock);
+    if (!fifosReady.owns_lock())
+        return;
+
+    // the editor can be created before prepareToPlay() reported a rate
+    auto sampleRate = audioProcessor.getSampleRate() > 0.0 ? audioProcessor.getSampleRate() : 48000.0;
+    if (sampleRate != preparedSampleRate)
+        prepareEngines(sampleRate);
+
+    applyDistributionMode(sampleRate);
+
+    if (requestedSpectrumColumns.load() != spectrum.getNumColumns())
+        spectrum.setColumns(requestedSpectrumColumns.load(), SPECTRUM_MIN_HZ, SPECTRUM_MAX_HZ);
+
+    if (truePeakResetPending.exchange(false))
+    {
+        results.maxTruePeak = 0.0f;
+        results.numTruePeakOvers = 0;
+    }
+
+    if (!isVisible())
+    {
+        // nobody draws the levels or the sample-based views, the next editor
+        // starts them from fresh audio
+        drainRecords();
+        resetLevels();
+
+        audioBufferFifo.discard();
+        lastDrainTime.store(juce::Time::getMillisecondCounter());
+        return;
+    }
+
+    // levels keep accumulating until the editor has seen them, so a late
+    // frame never loses a peak
+    if (acknowledgedSequence.load() == results.sequence)
+        resetLevels();
+
+    auto hasNewRecords = drainRecords();
+    auto hasNewSamples = analyseSamples();
+    lastDrainTime.store(juce::Time::getMillisecondCounter());
+    if (!hasNewRecords && !hasNewSamples)
+        return;
+
+    if (results.hasLevels)
+    {
+        float peakDbSum = 0.0f, rmsDbSum = 0.0f;
+        for (int channel = 0; channel < results.numChannels; ++channel)
+        {
+            results.peakDb[channel] = toDb(levels[channel].getPeak());
+            results.rmsDb[channel] = toDb(levels[channel].getRMS());
+            results.ppmDb[channel] = toDb(ballisticLevels[channel].ppm);
+            results.averageDb[channel] = toDb(ballisticLevels[channel].average);
+            peakDbSum += results.peakDb[channel];
+            rmsDbSum += results.rmsDb[channel];
+        }
+
+        results.peakHistogramDb = peakDbSum / results.numChannels;
+        results.rmsHistogramDb = rmsDbSum / results.numChannels;
+
+        copyDistribution(peakDistribution, results.peakDistribution);
+        copyDistribution(rmsDistribution, results.rmsDistribution);
+    }
+
+    ++results.sequence;
+    snapshots.getWriteBuffer() = results;
+    snapshots.publish();
+}
+
+bool MeterAnalyser::drainRecords()
+{
+    bool hasNewRecords = false;
+
+    MeterRecord record;
+    while (meterRecordFifo.pull(record))
+    {
+        if (record.numSamples == 0 || record.numChannels == 0)
+            continue;
+
+        float peakDbSum = 0.0f, rmsDbSum = 0.0f;
+        for (int channel = 0; channel < record.numChannels; ++channel)
+        {
+            // peak meters and histograms show true peak, sample peak misses inter-sample overs
+            auto& meterChannel = record.channels[channel];
+            levels[channel].add(meterChannel.truePeak, meterChannel.sumOfSquares, record.numSamples);
+
+            peakDbSum += toDb(meterChannel.truePeak);
+            rmsDbSum += toDb(std::sqrt(meterChannel.sumOfSquares / record.numSamples));
+
+            ballisticLevels[channel].ppm = juce::jmax(ballisticLevels[channel].ppm, meterChannel.ppm);
+            ballisticLevels[channel].average = juce::jmax(ballisticLevels[channel].average, meterChannel.average);
+
+            results.maxTruePeak = juce::jmax(results.maxTruePeak, meterChannel.truePeak);
+            results.numTruePeakOvers += meterChannel.numOvers;
+        }
+
+        // weighted by block length, so the distribution is over time
+        peakDistribution.add(peakDbSum / record.numChannels, record.numSamples);
+        rmsDistribution.add(rmsDbSum / record.numChannels, record.numSamples);
+
+        results.numChannels = record.numChannels;
+        results.loudness = record.loudness;
+        results.hasLevels = true;
+        hasNewRecords = true;
+    }
+
+    return hasNewRecords;
+}
+
+void MeterAnalyser::resetLevels()
+{
+    for (auto& level : levels)
+        level.reset();
+
+    ballisticLevels.fill({});
+    results.hasLevels = false;
+}
+
+bool MeterAnalyser::analyseSamples()
+{
+    auto numSamples = audioBufferFifo.pull(samples);
+    if (numSamples == 0 || samples.getNumChannels() == 0)
+        return false;
+
+    auto* left = samples.getReadPointer(0);
+    auto* right = samples.getReadPointer(juce::jmin(1, samples.getNumChannels() - 1));
+
+    slowEngine.process(left, right, numSamples);
+    peakEngine.process(left, right, numSamples);
+    results.slowCorrelation = slowEngine.getCorrelation();
+    results.peakCorrelation = peakEngine.getCorrelation();
+
+    // the history always covers the same time span, however the host
+    // chops its blocks
+    for (int i = 0; i < numSamples; ++i)
+        goniometerHistory.write({ left[i] - right[i], left[i] + right[i] });
+    copyGoniometerHistory();
+
+    if (spectrum.process(samples.getArrayOfReadPointers(), samples.getNumChannels(), numSamples))
+    {
+        auto* columnLevels = spectrum.getColumnLevels();
+        results.numSpectrumColumns = spectrum.getNumColumns();
+        std::copy(columnLevels, columnLevels + results.numSpectrumColumns, results.spectrumDb.begin());
+    }
+
+    return true;
+}
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    MeterAnalyser.h
+    Turns what the audio thread records into the results the editor draws.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalysisService.h"
+
+#define GONIOMETER_HISTORY_MS 20.0
+#define SPECTRUM_MIN_HZ 20.0f
+#define SPECTRUM_MAX_HZ 20000.0f
+//==============================================================================
+/** Everything the analysis hands over to the editor for one frame. */
+struct AnalysisResults
+{
+    static constexpr int maxGoniometerPoints = 4096;
+
+    int sequence{ 0 };
+    int numChannels{ 0 };
+
+    // levels of everything that arrived since the editor last picked up results
+    bool hasLevels{ false };
+    std::array<float, MAX_CHANNELS> peakDb, rmsDb;
+    // the audio thread's PPM and RMS/VU integrators
+    std::array<float, MAX_CHANNELS> ppmDb, averageDb;
+    float peakHistogramDb{ NEGATIVE_INFINITY }, rmsHistogramDb{ NEGATIVE_INFINITY };
+
+    // 0.5 dB bins from NEGATIVE_INFINITY to MAX_DECIBELS
+    static constexpr int numDistributionBins = 156;
+
+    struct Distribution
+    {
+        std::array<float, numDistributionBins> fractions{};
+        float p10{ NEGATIVE_INFINITY }, p50{ NEGATIVE_INFINITY }, p95{ NEGATIVE_INFINITY };
+    };
+
+    Distribution peakDistribution, rmsDistribution;
+
+    float peakCorrelation{ 0.0f }, slowCorrelation{ 0.0f };
+
+    // side (x) and mid (y) of the last GONIOMETER_HISTORY_MS, oldest first
+    std::array<juce::Point<float>, maxGoniometerPoints> goniometerPoints;
+    int numGoniometerPoints{ 0 };
+
+    LoudnessEngine::Values loudness;
+
+    // loudest bin per pixel column of the spectrum, in dB
+    std::array<float, SpectrumEngine::maxColumns> spectrumDb;
+    int numSpectrumColumns{ 0 };
+
+    // held since the last resetTruePeakHold()
+    float maxTruePeak{ 0.0f };
+    int numTruePeakOvers{ 0 };
+};
+//==============================================================================
+/**
+    The analysis of one plugin instance: the single consumer of the
+    processor's meter record Fifo and SampleFifo. It is owned by the
+    processor and run by the shared AnalysisService, at full rate while an
+    editor is open. Without one, a pass only feeds the accumulators that
+    must not miss any audio (true peak, loudness and the distributions),
+    throws the raw samples away and publishes nothing.
+*/
+struct MeterAnalyser : AnalysisService::Client
+{
+    MeterAnalyser(juce::AudioProcessor& processor, Fifo<MeterRecord, 512>& recordFifo, SampleFifo<float>& sampleFifo);
+    ~MeterAnalyser() override;
+
+    void analyse() override;
+    bool isVisible() const override { return editorVisible.load(); }
+    /** Message thread, by the editor while it exists. */
+    void setEditorVisible(bool isEditorVisible) { editorVisible.store(isEditorVisible); }
+    /** Held while the processor resizes the FIFOs, passes in the meantime are skipped. */
+    std::unique_lock<std::mutex> pauseAnalysis() { return std::unique_lock<std::mutex>(fifoLock); }
+    /** Any thread: how long ago a pass last emptied the FIFOs, whether or not they held anything. */
+    juce::uint32 getMillisecondsSinceLastDrain() const;
+
+    /** Message thread: picks up the newest results, false if nothing new was published. */
+    bool pullResults();
+    const AnalysisResults& getResults() const;
+
+    enum DistributionMode { Session, Decay, Window };
+    /** Any thread, applied on the next analysis pass. */
+    void setDistributionMode(int newMode);
+    void resetDistributions();
+    void resetTruePeakHold();
+    /** Any thread, one spectrum column per pixel of the analyser. */
+    void setSpectrumColumns(int numColumns);
+
+private:
+    using Distribution = LevelDistribution<AnalysisResults::numDistributionBins>;
+
+    void applyDistributionMode(double sampleRate);
+    static void copyDistribution(const Distribution& source, AnalysisResults::Distribution& dest);
+    void prepareEngines(double sampleRate);
+    void copyGoniometerHistory();
+    bool drainRecords();
+    void resetLevels();
+    bool analyseSamples();
+
+    juce::SharedResourcePointer<AnalysisService> service;
+    juce::AudioProcessor& audioProcessor;
+    Fifo<MeterRecord, 512>& meterRecordFifo;
+    SampleFifo<float>& audioBufferFifo;
+    std::atomic<bool> editorVisible{ false };
+    std::mutex fifoLock;
+    std::atomic<juce::uint32> lastDrainTime{ juce::Time::getMillisecondCounter() };
+
+    juce::AudioBuffer<float> samples;
+    std::array<LevelAccumulator, MAX_CHANNELS> levels;
+    std::array<MeterBallistics::Levels, MAX_CHANNELS> ballisticLevels;
+    CorrelationEngine slowEngine, peakEngine;
+    ReadAllAfterWriteCircularBuffer<juce::Point<float>> goniometerHistory{ {} };
+    SpectrumEngine spectrum;
+    std::atomic<int> requestedSpectrumColumns{ 0 };
+    double preparedSampleRate{ 0.0 };
+
+    Distribution peakDistribution{ NEGATIVE_INFINITY, MAX_DECIBELS }, rmsDistribution{ NEGATIVE_INFINITY, MAX_DECIBELS };
+    std::atomic<int> distributionMode{ Session };
+    std::atomic<bool> distributionResetPending{ false };
+    std::atomic<bool> truePeakResetPending{ false };
+
+    AnalysisResults results;
+    SnapshotBuffer<AnalysisResults> snapshots;
+    std::atomic<int> acknowledgedSequence{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(MeterAnalyser)
+};
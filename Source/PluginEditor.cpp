@@ -17,131 +17,41 @@ void NewLNF::drawLinearSlider(juce::Graphics& g, int x, int y, int width, int he
     g.drawRect(juce::Rectangle<float>{ static_cast<float>(x), sliderPos - 1.0f, static_cast<float>(width), 2.0f });
 }
 //==============================================================================
-ValueHolderBase::ValueHolderBase()
+void markDirty(juce::Component& component)
 {
-    startTimerHz(frameRate);
+    markDirty(component, component.getLocalBounds());
 }
 
-ValueHolderBase::~ValueHolderBase()
+void markDirty(juce::Component& component, juce::Rectangle<int> area)
 {
-    stopTimer();
-}
-
-void ValueHolderBase::timerCallback()
-{
-    if (getNow() - peakTime > holdTime && !infiniteHold)
-    {
-        timerCallbackImpl();
-    }
-}
-
-void ValueHolderBase::setHoldTime(int ms)
-{
-    holdTime = ms;
-    if (holdTime == std::numeric_limits<int>::max()) { infiniteHold = true; }
-    else { infiniteHold = false; }
-}
-
-float ValueHolderBase::getCurrentValue() const { return currentValue; }
-
-bool ValueHolderBase::getIsOverThreshold() const { return currentValue > threshold; }
-
-bool ValueHolderBase::getInfiniteHold() const { return infiniteHold; }
-
-void ValueHolderBase::setThreshold(float th) { threshold = th; }
-
-float ValueHolderBase::getThreshold() const { return threshold; }
-
-juce::int64 ValueHolderBase::getNow() { return juce::Time::currentTimeMillis(); }
-
-juce::int64 ValueHolderBase::getPeakTime() const { return peakTime; }
-
-juce::int64 ValueHolderBase::getHoldTime() const { return holdTime; }
-
-int ValueHolderBase::frameRate = 60;
-//==============================================================================
-ValueHolder::ValueHolder() { holdTime = 500; }
-
-ValueHolder::~ValueHolder() = default;
-
-void ValueHolder::updateHeldValue(float v)
-{
-    currentValue = v;
-
-    if (getIsOverThreshold() || infiniteHold)
-    {
-        if (holdTime == 0)
-        {
-            heldValue = v;
-        }
-        else
-        {
-            peakTime = getNow();
-            if (v > heldValue)
-            {
-                heldValue = v;
-            }
-        }
-    }    
-}
-
-void ValueHolder::timerCallbackImpl()
-{
-    
-    if (!getIsOverThreshold())
-    {
-        heldValue = NEGATIVE_INFINITY;
-    }
-}
-
-float ValueHolder::getValue() const
-{
-    bool check = getIsOverThreshold();
-    if (check || infiniteHold || getNow() - peakTime <= holdTime) { return heldValue; }
-    else { return currentValue; }
+    if (auto* collector = component.findParentComponentOfClass<DirtyAreaCollector>())
+        collector->markDirty(component, area);
+    else
+        component.repaint(area);
 }
-
-float ValueHolder::getHeldValue() const { return heldValue; }
 //==============================================================================
-DecayingValueHolder::DecayingValueHolder() : decayRateMultiplier(1/*3*/)
-{
-    setDecayRate(3);
-}
+FrameClock::~FrameClock() { stopTimer(); }
 
-DecayingValueHolder::~DecayingValueHolder() = default;
+juce::int64 FrameClock::getNow() const { return juce::Time::currentTimeMillis(); }
 
-void DecayingValueHolder::updateHeldValue(float v)
+void FrameClock::wake()
 {
-    if (v > currentValue || v == NEGATIVE_INFINITY)
-    {
-        peakTime = getNow();
-        currentValue = v;
-        resetDecayRateMultiplier();
-    }
+    if (!isTimerRunning())
+        startTimerHz(ValueHolderBase::frameRate);
 }
 
-void DecayingValueHolder::timerCallbackImpl()
+void FrameClock::timerCallback()
 {
-    currentValue = juce::jlimit<float>(NEGATIVE_INFINITY,
-        MAX_DECIBELS,
-        currentValue - decayRatePerFrame * decayRateMultiplier);
-
-    decayRateMultiplier += 0.05f;
-
-    if (currentValue <= NEGATIVE_INFINITY)
-    {
-        resetDecayRateMultiplier();
-    }
+    if (!tick())
+        stopTimer();
 }
-
-void DecayingValueHolder::setDecayRate(float dbPerSec) { decayRatePerFrame = dbPerSec / frameRate; }
-
-void DecayingValueHolder::resetDecayRateMultiplier() { decayRateMultiplier = 1; }
 //==============================================================================
 TextMeter::TextMeter() : cachedValueDb(NEGATIVE_INFINITY)
 {
     valueHolder.setThreshold(0);
     valueHolder.updateHeldValue(NEGATIVE_INFINITY);
+    // the held value runs out without new input
+    valueHolder.onFrame = [this] { repaintIfChanged(); };
 }
 
 void TextMeter::setThreshold(float threshold) { valueHolder.setThreshold(threshold); }
@@ -152,53 +62,67 @@ void TextMeter::update(float valueDb)
 {
     cachedValueDb = valueDb;
     valueHolder.updateHeldValue(cachedValueDb);
+    repaintIfChanged();
+}
+
+void TextMeter::repaintIfChanged()
+{
+    auto text = getDisplayText();
+    auto overThreshold = valueHolder.getIsOverThreshold();
+    if (text != displayedText || overThreshold != displayedOverThreshold)
+    {
+        displayedText = text;
+        displayedOverThreshold = overThreshold;
+        markDirty(*this);
+    }
+}
+
+juce::String TextMeter::getDisplayText() const
+{
+    auto valueToDisplay = valueHolder.getValue();
+    return (valueToDisplay > NEGATIVE_INFINITY) ? juce::String(valueToDisplay, 1) : juce::String("-inf");
 }
 
 void TextMeter::paint(juce::Graphics& g)
 {
+    // only repainted when the text changed, so there is nothing worth caching
     auto bounds = getLocalBounds();
-    juce::Colour textColor{ juce::Colours::white };
-    //auto valueToDisplay = NEGATIVE_INFINITY;
-    auto now = ValueHolder::getNow();
-    auto valueToDisplay = valueHolder.getValue();
-    // +++ FIX THIS CONDITION +++
-    //if (valueHolder.getIsOverThreshold() ||
-    //    (now - valueHolder.getPeakTime() < valueHolder.getHoldTime()) &&
-    //    valueHolder.getPeakTime() > valueHolder.getHoldTime())     // for plugin launch
-    if (valueHolder.getIsOverThreshold())
 
-    {
-        g.setColour(juce::Colours::red);
-        g.fillRect(bounds);
-        textColor = juce::Colours::black;
-        //valueToDisplay = valueHolder.getHeldValue();
-    }
-    else
-    {
-        g.setColour(juce::Colours::black);
-        g.fillRect(bounds);
-        textColor = juce::Colours::white;
-        //valueToDisplay = valueHolder.getCurrentValue();
-    }
+    g.setColour(displayedOverThreshold ? juce::Colours::red : juce::Colours::black);
+    g.fillRect(bounds);
 
-    g.setColour(textColor);
+    g.setColour(displayedOverThreshold ? juce::Colours::black : juce::Colours::white);
     g.setFont(12);
-
-    g.drawFittedText((valueToDisplay > NEGATIVE_INFINITY) ? juce::String(valueToDisplay, 1) : juce::String("-inf"),
-        bounds,
-        juce::Justification::centred,
-        1);
+    g.drawFittedText(displayedText, bounds, juce::Justification::centred, 1);
 }
 //==============================================================================
-void Meter::setThreshold(float threshold) { decayingValueHolder.setThreshold(threshold); }
+Meter::Meter()
+{
+    // hold and decay of the tick continue after the audio stops
+    decayingValueHolder.onFrame = [this] { repaintIfChanged(); };
+}
 
-void Meter::toggleTicks(bool toggleState) { showTicks = toggleState; }
+void Meter::setThreshold(float threshold)
+{
+    decayingValueHolder.setThreshold(threshold);
+    repaintIfChanged();
+}
+
+void Meter::toggleTicks(bool toggleState)
+{
+    showTicks = toggleState;
+    repaintIfChanged();
+}
 
 void Meter::setDecayRate(float dbPerSec) { decayingValueHolder.setDecayRate(dbPerSec); }
 
 void Meter::setHoldDuration(int newDuration) { decayingValueHolder.setHoldTime(newDuration); }
 
-void Meter::resetHeldValue() { decayingValueHolder.updateHeldValue(NEGATIVE_INFINITY); }
+void Meter::resetHeldValue()
+{
+    decayingValueHolder.updateHeldValue(NEGATIVE_INFINITY);
+    repaintIfChanged();
+}
 
 void Meter::paint(juce::Graphics& g)
 {
@@ -239,7 +163,39 @@ void Meter::update(float Level)
 {
     peakDb = Level;
     decayingValueHolder.updateHeldValue(peakDb);
-    repaint();
+    repaintIfChanged();
+}
+
+Meter::DisplayState Meter::getDisplayState() const
+{
+    auto bounds = getLocalBounds().reduced(1);
+
+    auto remap = [&](float value) -> int
+    {
+        return juce::roundToInt(juce::jmap<float>(value,
+            NEGATIVE_INFINITY,
+            MAX_DECIBELS,
+            bounds.getBottom(),
+            bounds.getY()));
+    };
+
+    DisplayState state;
+    state.peakY = remap(peakDb);
+    state.thresholdY = remap(decayingValueHolder.getThreshold());
+    state.tickY = remap(decayingValueHolder.getCurrentValue());
+    state.overThreshold = decayingValueHolder.getIsOverThreshold();
+    state.showTicks = showTicks;
+    return state;
+}
+
+void Meter::repaintIfChanged()
+{
+    auto state = getDisplayState();
+    if (state == displayedState)
+        return;
+
+    displayedState = state;
+    markDirty(*this);
 }
 //==============================================================================
 void DbScale::paint(juce::Graphics& g)
@@ -292,7 +248,6 @@ std::vector<Tick> DbScale::getTicks(int dbDivision, juce::Rectangle<int> meterBo
 }
 //==============================================================================
 MacroMeter::MacroMeter(int orientation) :
-    averager(ValueHolderBase::frameRate, NEGATIVE_INFINITY),
     orientation(orientation)
 {
     addAndMakeVisible(avgMeter);
@@ -300,7 +255,7 @@ MacroMeter::MacroMeter(int orientation) :
     addAndMakeVisible(textMeter);
 }
 
-MacroMeter::~MacroMeter() { averager.clear(NEGATIVE_INFINITY); }
+MacroMeter::~MacroMeter() = default;
 
 bool MacroMeter::getOrientation() const { return orientation; }
 
@@ -343,8 +298,6 @@ void MacroMeter::setHoldDuration(int newDuration)
     textMeter.setHoldDuration(newDuration);
 }
 
-void MacroMeter::setAvgDuration(float avgDuration) { averager.resize(avgDuration, NEGATIVE_INFINITY); }
-
 void MacroMeter::resetHeldValue()
 {
     avgMeter.resetHeldValue();
@@ -357,10 +310,9 @@ void MacroMeter::setDecayRate(float dbPerSec)
     peakMeter.setDecayRate(dbPerSec);
 }
 
-void MacroMeter::update(float level)
+void MacroMeter::update(float level, float averageLevel)
 {
-    averager.add(level);
-    avgMeter.update(averager.getAvg());
+    avgMeter.update(averageLevel);
     peakMeter.update(level);
     textMeter.update(level);
 }
@@ -388,10 +340,10 @@ juce::Rectangle<int> MacroMeter::getAvgMeterBounds() const { return avgMeter.get
 
 int MacroMeter::getTextMeterHeight() const { return textMeter.getHeight(); }
 //==============================================================================
-StereoMeter::StereoMeter(juce::String labelName, juce::String labelText) : label(labelName, labelText)
+StereoMeter::StereoMeter(juce::String labelName, juce::String labelText) :
+    labelName(labelName),
+    labelText(labelText)
 {
-    addAndMakeVisible(leftMacroMeter);
-    addAndMakeVisible(rightMacroMeter);
     addAndMakeVisible(dbScale);
     addAndMakeVisible(label);
 
@@ -402,76 +354,127 @@ StereoMeter::StereoMeter(juce::String labelName, juce::String labelText) : label
     label.setColour(juce::Label::outlineColourId, juce::Colours::darkgrey);
     label.setColour(juce::Label::textColourId, juce::Colours::darkgrey);
     label.setFont(18);
+
+    setNumChannels(2);
 }
 
 // empty ref in threshold slider cause newLNF is deleted earlier
 StereoMeter::~StereoMeter() { thresholdSlider.setLookAndFeel(nullptr); }
 
+void StereoMeter::setNumChannels(int numChannels)
+{
+    numChannels = juce::jlimit(1, MAX_CHANNELS, numChannels);
+    if (numChannels == macroMeters.size())
+        return;
+
+    macroMeters.clear();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* macroMeter = macroMeters.add(new MacroMeter(channel < (numChannels + 1) / 2 ? Left : Right));
+        macroMeter->setThreshold(threshold);
+        macroMeter->showMeters(meterMode);
+        macroMeter->toggleTicks(showTicks);
+        macroMeter->setHoldDuration(holdDuration);
+        macroMeter->setDecayRate(decayRate);
+        addAndMakeVisible(macroMeter);
+    }
+
+    label.setText(numChannels == 2 ? labelText : labelName, juce::dontSendNotification);
+    resized();
+}
+
+int StereoMeter::getNumChannels() const { return macroMeters.size(); }
+
+int StereoMeter::getNumLeftColumns() const { return (macroMeters.size() + 1) / 2; }
+
+// 25px per meter column plus the scale in the middle and a 5px margin
+int StereoMeter::getPreferredWidth() const { return 10 + 25 * juce::jmax(2, macroMeters.size()) + 25; }
+
 void StereoMeter::showMeters(const juce::String& meter)
 {
-    leftMacroMeter.showMeters(meter);
-    rightMacroMeter.showMeters(meter);
+    meterMode = meter;
+    for (auto* macroMeter : macroMeters)
+        macroMeter->showMeters(meter);
 }
 
 void StereoMeter::toggleTicks(bool toggleState)
 {
-    leftMacroMeter.toggleTicks(toggleState);
-    rightMacroMeter.toggleTicks(toggleState);
+    showTicks = toggleState;
+    for (auto* macroMeter : macroMeters)
+        macroMeter->toggleTicks(toggleState);
 }
 
-void StereoMeter::setThreshold(float threshold)
+void StereoMeter::setThreshold(float newThreshold)
 {
-    leftMacroMeter.setThreshold(threshold);
-    rightMacroMeter.setThreshold(threshold);
+    threshold = newThreshold;
+    for (auto* macroMeter : macroMeters)
+        macroMeter->setThreshold(newThreshold);
 }
 
 void StereoMeter::setHoldDuration(int newDuration)
 {
-    leftMacroMeter.setHoldDuration(newDuration);
-    rightMacroMeter.setHoldDuration(newDuration);
+    holdDuration = newDuration;
+    for (auto* macroMeter : macroMeters)
+        macroMeter->setHoldDuration(newDuration);
 }
 
 void StereoMeter::resetHeldValue()
 {
-    leftMacroMeter.resetHeldValue();
-    rightMacroMeter.resetHeldValue();
+    for (auto* macroMeter : macroMeters)
+        macroMeter->resetHeldValue();
 }
 
 void StereoMeter::setDecayRate(float dbPerSec)
 {
-    leftMacroMeter.setDecayRate(dbPerSec);
-    rightMacroMeter.setDecayRate(dbPerSec);
+    decayRate = dbPerSec;
+    for (auto* macroMeter : macroMeters)
+        macroMeter->setDecayRate(dbPerSec);
 }
 
-void StereoMeter::setAverageDuration(float avgDuration)
+void StereoMeter::update(const std::array<float, MAX_CHANNELS>& levels, const std::array<float, MAX_CHANNELS>& averageLevels)
 {
-    leftMacroMeter.setAvgDuration(avgDuration);
-    rightMacroMeter.setAvgDuration(avgDuration);
-}
-
-void StereoMeter::update(float levelLeft, float levelRight)
-{
-    leftMacroMeter.update(levelLeft);
-    rightMacroMeter.update(levelRight);
-    repaint();
+    for (int channel = 0; channel < macroMeters.size(); ++channel)
+        macroMeters[channel]->update(levels[channel], averageLevels[channel]);
 }
 
 void StereoMeter::resized()
 {
+    if (macroMeters.isEmpty())
+        return;
+
     auto bounds = getLocalBounds().reduced(5);
 
     label.setBounds(bounds.removeFromBottom(25));
 
-    leftMacroMeter.setBounds(bounds.removeFromLeft(25));
-    rightMacroMeter.setBounds(bounds.removeFromRight(25));
+    auto numLeftColumns = getNumLeftColumns();
+    for (int channel = 0; channel < numLeftColumns; ++channel)
+        macroMeters[channel]->setBounds(bounds.removeFromLeft(25));
+
+    for (int channel = macroMeters.size() - 1; channel >= numLeftColumns; --channel)
+        macroMeters[channel]->setBounds(bounds.removeFromRight(25));
+
+    // a single column still leaves room for the scale on its right
+    if (macroMeters.size() == 1)
+        bounds.removeFromRight(25);
+
+    auto* referenceMeter = macroMeters.getFirst();
     dbScale.setBounds(bounds);
-    dbScale.buildBackgroundImage(6, leftMacroMeter.getAvgMeterBounds(), NEGATIVE_INFINITY, MAX_DECIBELS);
-    thresholdSlider.setBounds(bounds.removeFromBottom(bounds.getHeight() - leftMacroMeter.getTextMeterHeight()).expanded(0, 12));
+    dbScale.buildBackgroundImage(6, referenceMeter->getAvgMeterBounds(), NEGATIVE_INFINITY, MAX_DECIBELS);
+    thresholdSlider.setBounds(bounds.removeFromBottom(bounds.getHeight() - referenceMeter->getTextMeterHeight()).expanded(0, 12));
 }
 //==============================================================================
 Histogram::Histogram(const juce::String& title_) : title(title_) { }
 
-void Histogram::setThreshold(float newThreshold) { threshold = newThreshold; }
+void Histogram::setThreshold(float newThreshold)
+{
+    threshold = newThreshold;
+    // the colouring is baked into the columns
+    redrawPlot();
+    repaint();
+}
+
+juce::Rectangle<int> Histogram::getPlotBounds() const { return getLocalBounds().reduced(5).reduced(1); }
 
 void Histogram::paint(juce::Graphics& g)
 {
@@ -482,80 +485,195 @@ void Histogram::paint(juce::Graphics& g)
     g.setColour(juce::Colours::darkgrey);
     g.drawText(title, bounds, juce::Justification::centredBottom);
 
-    displayPath(g, bounds.toFloat().reduced(1));
+    if (showDistribution)
+    {
+        paintDistribution(g, getPlotBounds());
+        return;
+    }
+
+    if (!plot.isValid())
+        return;
+
+    auto plotBounds = getPlotBounds();
+    auto width = plot.getWidth();
+    auto height = plot.getHeight();
+    auto oldest = static_cast<int>(buffer.getReadIndex());
+
+    g.drawImage(plot, plotBounds.getX(), plotBounds.getY(), width - oldest, height, oldest, 0, width - oldest, height);
+    g.drawImage(plot, plotBounds.getX() + width - oldest, plotBounds.getY(), oldest, height, 0, 0, oldest, height);
 }
 
-void Histogram::resized() { buffer.resize(getWidth(), NEGATIVE_INFINITY); }
+void Histogram::resized()
+{
+    auto plotBounds = getPlotBounds();
+    if (plotBounds.isEmpty())
+    {
+        plot = {};
+        return;
+    }
+
+    buffer.resize(plotBounds.getWidth(), NEGATIVE_INFINITY);
+    numNonEmptyColumns = 0;
+    plot = juce::Image(juce::Image::PixelFormat::ARGB, plotBounds.getWidth(), plotBounds.getHeight(), true, juce::SoftwareImageType());
+}
 
 void Histogram::mouseDown(const juce::MouseEvent& e)
 {
+    if (showDistribution)
+    {
+        if (onDistributionClear)
+            onDistributionClear();
+        return;
+    }
+
     buffer.clear(NEGATIVE_INFINITY);
+    numNonEmptyColumns = 0;
+    redrawPlot();
     repaint();
 }
 
 void Histogram::update(float value)
 {
+    auto x = static_cast<int>(buffer.getReadIndex());
+    auto& data = buffer.getData();
+    auto previousValue = data[x == 0 ? data.size() - 1 : x - 1];
+    auto evictedNonEmpty = data[x] > NEGATIVE_INFINITY;
+
     buffer.write(value);
+    numNonEmptyColumns += (value > NEGATIVE_INFINITY ? 1 : 0) - (evictedNonEmpty ? 1 : 0);
+
+    if (plot.isValid())
+        drawColumn(x, value, previousValue);
+
+    // one more repaint after the last non-empty column scrolled out
+    if (!showDistribution && (numNonEmptyColumns > 0 || evictedNonEmpty))
+        markDirty(*this);
+}
+
+void Histogram::updateDistribution(const AnalysisResults::Distribution& newDistribution)
+{
+    distribution = newDistribution;
+
+    if (!showDistribution)
+        return;
+
+    auto area = getPlotBounds().toFloat();
+    auto& fractions = distribution.fractions;
+    auto maxFraction = *std::max_element(fractions.begin(), fractions.end());
+
+    decltype(displayedDistribution) displayed{};
+    if (maxFraction > 0.0f)
+    {
+        for (int bin = 0; bin < AnalysisResults::numDistributionBins; ++bin)
+            displayed[bin] = juce::roundToInt(area.getHeight() * fractions[bin] / maxFraction);
+
+        auto mapDb = [&area](float db) -> int
+            { return juce::roundToInt(juce::jmap(db, NEGATIVE_INFINITY, MAX_DECIBELS, area.getX(), area.getRight())); };
+
+        // the labels print one decimal, so they change more often than the lines move
+        auto bins = AnalysisResults::numDistributionBins;
+        displayed[bins] = mapDb(distribution.p10) * 1000 + juce::roundToInt(distribution.p10 * 10.0f);
+        displayed[bins + 1] = mapDb(distribution.p50) * 1000 + juce::roundToInt(distribution.p50 * 10.0f);
+        displayed[bins + 2] = mapDb(distribution.p95) * 1000 + juce::roundToInt(distribution.p95 * 10.0f);
+    }
+
+    if (displayed != displayedDistribution)
+    {
+        displayedDistribution = displayed;
+        markDirty(*this);
+    }
+}
+
+void Histogram::setDistributionView(bool shouldShowDistribution)
+{
+    showDistribution = shouldShowDistribution;
+    displayedDistribution = {};
     repaint();
 }
 
-void Histogram::displayPath(juce::Graphics& g, juce::Rectangle<float> bounds)
+void Histogram::paintDistribution(juce::Graphics& g, juce::Rectangle<int> bounds)
 {
-    juce::Path fill = buildPath(path, buffer, bounds);
-    if (!fill.isEmpty())
+    auto& fractions = distribution.fractions;
+    auto maxFraction = *std::max_element(fractions.begin(), fractions.end());
+    if (maxFraction <= 0.0f)
+        return;
+
+    auto area = bounds.toFloat();
+    auto binWidth = area.getWidth() / AnalysisResults::numDistributionBins;
+    auto mapDb = [&area](float db) -> float
+        { return juce::jmap(db, NEGATIVE_INFINITY, MAX_DECIBELS, area.getX(), area.getRight()); };
+
+    for (int bin = 0; bin < AnalysisResults::numDistributionBins; ++bin)
     {
-        juce::ColourGradient gradient;
-        float remappedThreshold = juce::jmap(threshold, NEGATIVE_INFINITY, MAX_DECIBELS, 0.01f, 1.0f);
+        auto binDb = juce::jmap(static_cast<float>(bin), 0.0f, static_cast<float>(AnalysisResults::numDistributionBins), NEGATIVE_INFINITY, MAX_DECIBELS);
+        auto height = area.getHeight() * fractions[bin] / maxFraction;
 
-        gradient.addColour(0.0, juce::Colours::white.withAlpha(0.15f));
-        gradient.addColour(remappedThreshold - 0.01, juce::Colours::white.withAlpha(0.15f));
-        gradient.addColour(remappedThreshold, juce::Colours::red.withAlpha(0.45f));
-        gradient.addColour(1.0f, juce::Colours::red.withAlpha(0.45f));
-        
-        gradient.point1 = bounds.getBottomLeft();
-        gradient.point2 = bounds.getTopLeft();
+        g.setColour(binDb >= threshold ? juce::Colours::red.withAlpha(0.45f) : juce::Colours::white.withAlpha(0.15f));
+        g.fillRect(area.getX() + bin * binWidth, area.getBottom() - height, binWidth, height);
+    }
+
+    juce::Array<std::pair<juce::String, float>> percentiles{ { "P10", distribution.p10 },
+                                                             { "P50", distribution.p50 },
+                                                             { "P95", distribution.p95 } };
+    g.setFont(11);
 
-        g.setGradientFill(gradient);
-        g.fillPath(fill);
+    for (int i = 0; i < percentiles.size(); ++i)
+    {
+        auto x = mapDb(percentiles[i].second);
         g.setColour(juce::Colours::white);
-        g.strokePath(path, juce::PathStrokeType(1));
+        g.drawVerticalLine(juce::roundToInt(x), area.getY(), area.getBottom());
+        g.drawText(percentiles[i].first + " " + juce::String(percentiles[i].second, 1),
+                   bounds.withTrimmedTop(i * 12).withHeight(12).withX(juce::roundToInt(x) + 2).withWidth(70),
+                   juce::Justification::centredLeft);
     }
 }
 
-juce::Path Histogram::buildPath(juce::Path& p,
-                                ReadAllAfterWriteCircularBuffer<float>& buffer,
-                                juce::Rectangle<float> bounds)
+void Histogram::drawColumn(int x, float value, float previousValue)
 {
-    p.clear();
-    auto size = buffer.getSize();
-    auto& data = buffer.getData();
-    auto readIndex = buffer.getReadIndex();
+    auto height = plot.getHeight();
+    plot.clear({ x, 0, 1, height });
 
-    auto map = [&bounds](float db) -> float
-        { return juce::jmap(db, NEGATIVE_INFINITY, MAX_DECIBELS, bounds.getBottom(), bounds.getY()); };
+    auto map = [height](float db) -> int
+        { return juce::roundToInt(juce::jmap(db, NEGATIVE_INFINITY, MAX_DECIBELS, static_cast<float>(height), 0.0f)); };
 
-    auto increment = [&size](size_t& readIndex)
-    {
-        if (readIndex == size - 1) { readIndex = 0; }
-        else { ++readIndex; }
-    };
+    auto y = map(value);
+    if (y >= height && map(previousValue) >= height)
+        return;
+
+    auto thresholdY = juce::jlimit(0, height, map(threshold));
 
-    p.startNewSubPath(bounds.getX(), map(data[readIndex]));
-    increment(readIndex);
+    juce::Graphics g(plot);
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    g.fillRect(x, juce::jmax(y, thresholdY), 1, height - juce::jmax(y, thresholdY));
 
-    for (int x = 1; x < bounds.getWidth(); ++x)
+    if (y < thresholdY)
     {
-        p.lineTo(bounds.getX() + x, map(data[readIndex]));
-        increment(readIndex);
+        g.setColour(juce::Colours::red.withAlpha(0.45f));
+        g.fillRect(x, y, 1, thresholdY - y);
     }
-    
-    if (p.getBounds().isEmpty()) { p.clear(); return p; }
 
-    auto fill = p;
-    fill.lineTo(bounds.getBottomRight());
-    fill.lineTo(bounds.getBottomLeft());
-    fill.closeSubPath();
-    return fill;
+    // the outline joins this column to the previous one
+    auto previousY = map(previousValue);
+    g.setColour(juce::Colours::white);
+    g.fillRect(x, juce::jmin(y, previousY), 1, std::abs(y - previousY) + 1);
+}
+
+void Histogram::redrawPlot()
+{
+    if (!plot.isValid())
+        return;
+
+    plot.clear(plot.getBounds());
+
+    auto& data = buffer.getData();
+    auto oldest = buffer.getReadIndex();
+
+    for (size_t x = 0; x < data.size(); ++x)
+    {
+        // the oldest column has no predecessor on screen
+        auto previous = x == oldest ? x : (x == 0 ? data.size() - 1 : x - 1);
+        drawColumn(static_cast<int>(x), data[x], data[previous]);
+    }
 }
 //==============================================================================
 HistogramContainer::HistogramContainer()
@@ -584,58 +702,104 @@ void HistogramContainer::setFlex(juce::FlexBox::Direction directionType, juce::R
 
 void HistogramContainer::resized() { setFlex(juce::FlexBox::Direction::column, getLocalBounds()); }
 //==============================================================================
-Goniometer::Goniometer(juce::AudioBuffer<float>& buffer) : buffer(buffer) { internalBuffer = juce::AudioBuffer<float>(2, 256); }
-
 void Goniometer::setScale(float& coefficient) { scaleCoefficient = coefficient; }
 
-void Goniometer::paint(juce::Graphics& g)
+void Goniometer::update(const AnalysisResults& results)
 {
-    p.clear();
-    if (buffer.getNumSamples() >= JUCE_LIVE_CONSTANT(400)) { internalBuffer.makeCopyOf(buffer); } // 256
-    else { internalBuffer.applyGain(juce::Decibels::decibelsToGain(-2.0f)); }
-    
-    auto bounds = getLocalBounds().withTrimmedLeft((getWidth() - getHeight()) / 2).withTrimmedRight((getWidth() - getHeight()) / 2).toFloat();
+    if (phosphor.isNull())
+        return;
 
-    g.drawImage(bkgd, bounds);
+    // a trace parked on one pixel (silence, or DC) fades into a fixed image,
+    // after which fading and replotting would reproduce the same pixels
+    auto still = isStill(results);
+    if (still && framesUntilSettled == 0)
+        return;
 
-    auto map = [&](float value, float min, float max) -> float
-    {
-        value = juce::jmap(value,
-            -1.0f,
-            1.0f,
-            min,
-            max);
+    framesUntilSettled = still ? framesUntilSettled - 1 : framesToSettle;
 
-        return value;
-    };
+    juce::Image::BitmapData pixels(phosphor, juce::Image::BitmapData::readWrite);
+    fadePhosphor(pixels);
+    plotPoints(pixels, results);
+    markDirty(*this);
+}
 
-    auto reducedBounds = bounds.reduced(25).toFloat();
+juce::Point<int> Goniometer::mapToPixel(juce::Point<float> point, int diameter) const
+{
+    auto half = diameter * 0.5f;
+    auto limit = half - 1.0f;
+    auto gain = conversionCoefficient * scaleCoefficient * limit;
+
+    // +S is drawn to the left and +M to the top, like the background labels
+    auto x = -point.getX() * gain;
+    auto y = -point.getY() * gain;
 
-    for (int i = 0; i < internalBuffer.getNumSamples(); i += 2)
+    // Lissajous curve limitation, points outside are pulled onto the circle
+    auto distanceSquared = x * x + y * y;
+    if (distanceSquared > limit * limit)
     {
-        auto left = internalBuffer.getSample(0, i);
-        auto right = internalBuffer.getSample(1, i);
-        auto mid = (left + right) * conversionCoefficient * scaleCoefficient;
-        auto side = (left - right) * conversionCoefficient * scaleCoefficient;
+        auto toCircle = limit / std::sqrt(distanceSquared);
+        x *= toCircle;
+        y *= toCircle;
+    }
 
-        juce::Point<float> node{ map(side, reducedBounds.getRight(), reducedBounds.getX()),
-                                 map(mid, reducedBounds.getBottom(), reducedBounds.getY()) };
+    return { juce::jlimit(0, diameter - 1, static_cast<int>(half + x)),
+             juce::jlimit(0, diameter - 1, static_cast<int>(half + y)) };
+}
 
-        // Lissajous curve limitation criteria v2
+bool Goniometer::isStill(const AnalysisResults& results)
+{
+    juce::Point<int> singlePixel{ -1, -1 };
 
-        if (center.getDistanceFrom(node) >= radius)
+    if (results.numGoniometerPoints > 0)
+    {
+        auto diameter = phosphor.getWidth();
+        singlePixel = mapToPixel(results.goniometerPoints[0], diameter);
+
+        for (int i = 1; i < results.numGoniometerPoints; ++i)
         {
-            if (i == 0) { p.startNewSubPath(center.getPointOnCircumference(radius, center.getAngleToPoint(node))); }
-            else { p.lineTo(center.getPointOnCircumference(radius, center.getAngleToPoint(node))); }
-        }
-        else
-        {        
-            if (i == 0) { p.startNewSubPath(node); }
-            else { p.lineTo(node); }
+            if (mapToPixel(results.goniometerPoints[i], diameter) != singlePixel)
+            {
+                singlePixel = { -1, -1 };
+                break;
+            }
         }
     }
-    g.setColour(juce::Colours::white);
-    g.strokePath(p, juce::PathStrokeType(1));
+
+    auto still = singlePixel.getX() >= 0 && singlePixel == lastSinglePixel;
+    lastSinglePixel = singlePixel;
+    return still;
+}
+
+void Goniometer::fadePhosphor(juce::Image::BitmapData& pixels)
+{
+    // premultiplied ARGB, so scaling every byte fades colour and alpha alike
+    auto numBytes = pixels.width * pixels.pixelStride;
+    for (int y = 0; y < pixels.height; ++y)
+    {
+        auto* line = pixels.getLinePointer(y);
+        for (int i = 0; i < numBytes; ++i)
+            line[i] = static_cast<juce::uint8>((line[i] * phosphorDecay) >> 8);
+    }
+}
+
+void Goniometer::plotPoints(juce::Image::BitmapData& pixels, const AnalysisResults& results)
+{
+    for (int i = 0; i < results.numGoniometerPoints; ++i)
+    {
+        auto position = mapToPixel(results.goniometerPoints[i], pixels.width);
+        auto* pixel = pixels.getPixelPointer(position.getX(), position.getY());
+
+        for (int c = 0; c < pixels.pixelStride; ++c)
+            pixel[c] = static_cast<juce::uint8>(juce::jmin(255, pixel[c] + phosphorIntensity));
+    }
+}
+
+void Goniometer::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().withTrimmedLeft((getWidth() - getHeight()) / 2).withTrimmedRight((getWidth() - getHeight()) / 2).toFloat();
+
+    g.drawImage(bkgd, bounds);
+    g.drawImageAt(phosphor, static_cast<int>(bounds.getX()) + 25, static_cast<int>(bounds.getY()) + 25);
 }
 
 void Goniometer::drawBackground()
@@ -686,33 +850,49 @@ void Goniometer::resized()
     radius = getLocalBounds().reduced(25).getHeight() / 2;  // radius of goniometer background
     center = getLocalBounds().getCentre().toFloat();
     drawBackground();
+
+    // a software image, so the per-pixel writes stay in main memory
+    auto diameter = juce::jmax(1, radius * 2);
+    phosphor = juce::Image(juce::Image::PixelFormat::ARGB, diameter, diameter, true, juce::SoftwareImageType());
+    lastSinglePixel = { -1, -1 };
 }
 //==============================================================================
-CorrelationMeter::CorrelationMeter(juce::AudioBuffer<float>& buf, double sampleRate) : buffer(buf)
+void CorrelationMeter::update(float peakCorrelation, float slowCorrelation)
 {
-    for (auto& filter : filters)
+    peak = peakCorrelation;
+    slow = slowCorrelation;
+
+    auto meterBounds = getMeterBounds();
+    auto peakX = juce::roundToInt(juce::jmap<float>(peak, -1, 1, meterBounds.getX(), meterBounds.getRight()));
+    auto slowX = juce::roundToInt(juce::jmap<float>(slow, -1, 1, meterBounds.getX(), meterBounds.getRight()));
+
+    if (peakX != displayedPeakX || slowX != displayedSlowX)
     {
-        filter = juce::dsp::FIR::Filter<float>(juce::dsp::FilterDesign<float>
-                                                        ::designFIRLowpassWindowMethod(100.0f,
-                                                                                       sampleRate,
-                                                                                       3,
-                                                                                       juce::dsp::FilterDesign<float>::WindowingMethod::rectangular));
-        filter.reset();        
+        displayedPeakX = peakX;
+        displayedSlowX = slowX;
+        markDirty(*this);
     }
 }
 
+juce::Rectangle<float> CorrelationMeter::getMeterBounds() const
+{
+    return getLocalBounds().toFloat().withTrimmedLeft(labelWidth).withTrimmedRight(labelWidth);
+}
+
 void CorrelationMeter::paint(juce::Graphics& g)
 {
-    auto labelWidth = 25;
     auto labelBounds = getLocalBounds().withWidth(labelWidth).toFloat();
-    auto meterBounds = getLocalBounds().toFloat().withTrimmedLeft(labelWidth).withTrimmedRight(labelWidth);
+    auto meterBounds = getMeterBounds();
 
-    g.setColour(juce::Colours::darkgrey);
-    g.drawRect(meterBounds.withHeight(3));
-    g.drawRect(meterBounds.withHeight(20).translated(0, 5));
-    g.setColour(juce::Colours::white);
-    g.drawText(chars[0], labelBounds, juce::Justification::centred);
-    g.drawText(chars[1], labelBounds.withX(getLocalBounds().getRight() - labelWidth), juce::Justification::centred);
+    outline.draw(g, getLocalBounds(), 0, [&](juce::Graphics& gl)
+    {
+        gl.setColour(juce::Colours::darkgrey);
+        gl.drawRect(meterBounds.withHeight(3));
+        gl.drawRect(meterBounds.withHeight(20).translated(0, 5));
+        gl.setColour(juce::Colours::white);
+        gl.drawText(chars[0], labelBounds, juce::Justification::centred);
+        gl.drawText(chars[1], labelBounds.withX(getLocalBounds().getRight() - labelWidth), juce::Justification::centred);
+    });
 
     auto centerX = meterBounds.toFloat().getCentreX();
     auto remap = [&](float value) -> float
@@ -720,8 +900,8 @@ void CorrelationMeter::paint(juce::Graphics& g)
         return juce::jmap<float>(value, -1, 1, meterBounds.getX(), meterBounds.getRight());
     };
 
-    fillMeter(g, meterBounds.withHeight(3), remap(peakAverager.getAvg()), centerX);
-    fillMeter(g, meterBounds.withHeight(20).translated(0, 5), remap(slowAverager.getAvg()), centerX);
+    fillMeter(g, meterBounds.withHeight(3), remap(peak), centerX);
+    fillMeter(g, meterBounds.withHeight(20).translated(0, 5), remap(slow), centerX);
 }
 
 void CorrelationMeter::fillMeter(juce::Graphics & g, juce::Rectangle<float>& bounds, float edgeX1, float edgeX2)
@@ -733,35 +913,89 @@ void CorrelationMeter::fillMeter(juce::Graphics & g, juce::Rectangle<float>& bou
     g.setColour(juce::Colours::white);
     g.drawRect(bounds);
 }
+//==============================================================================
+juce::Rectangle<int> SpectrumAnalyser::getPlotBounds() const
+{
+    return getLocalBounds().reduced(1).withTrimmedBottom(labelHeight);
+}
+
+int SpectrumAnalyser::getNumColumns() const { return juce::jmin(getPlotBounds().getWidth(), SpectrumEngine::maxColumns); }
+
+void SpectrumAnalyser::resized()
+{
+    auto plot = getPlotBounds();
+    // written pixel by pixel every frame, so it must stay in system memory
+    bars = juce::Image(juce::Image::PixelFormat::ARGB, juce::jmax(1, plot.getWidth()), juce::jmax(1, plot.getHeight()), true,
+                       juce::SoftwareImageType());
+    displayedY.fill(bars.getHeight());
+}
 
-void CorrelationMeter::update()
+void SpectrumAnalyser::update(const AnalysisResults& results)
 {
-    auto bufferData = buffer.getArrayOfReadPointers();
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    if (bars.isNull())
+        return;
+
+    auto height = bars.getHeight();
+    auto barColour = juce::Colours::skyblue.withAlpha(0.8f);
+    auto numColumns = juce::jmin(results.numSpectrumColumns, getNumColumns());
+    juce::Rectangle<int> changed;
+
+    for (int column = 0; column < numColumns; ++column)
     {
-        // Pearson fitting criterion
-        float sqrt = std::sqrt(filters[1].processSample(bufferData[0][i] * bufferData[0][i]) *
-            filters[2].processSample(bufferData[1][i] * bufferData[1][i]));
+        auto y = juce::jlimit(0, height, juce::roundToInt(juce::jmap(results.spectrumDb[column], SPECTRUM_MIN_DB, 0.0f,
+                                                                     static_cast<float>(height), 0.0f)));
+        auto& displayed = displayedY[column];
+        if (y == displayed)
+            continue;
+
+        // only the difference between the old and the new top is touched
+        juce::Rectangle<int> span{ column, juce::jmin(y, displayed), 1, std::abs(y - displayed) };
+        if (y < displayed)
+            bars.clear(span, barColour);
+        else
+            bars.clear(span);
+
+        displayed = y;
+        changed = changed.isEmpty() ? span : changed.getUnion(span);
+    }
 
-        if (std::isnan(sqrt) || std::isinf(sqrt) || sqrt == 0)
+    if (!changed.isEmpty())
+        markDirty(*this, changed + getPlotBounds().getPosition());
+}
+
+void SpectrumAnalyser::paint(juce::Graphics& g)
+{
+    auto plot = getPlotBounds();
+
+    grid.draw(g, getLocalBounds(), 0, [&](juce::Graphics& gl)
+    {
+        gl.fillAll(juce::Colours::black);
+        gl.setColour(juce::Colours::darkgrey);
+        gl.drawRect(getLocalBounds());
+
+        for (float db = -10.0f; db > SPECTRUM_MIN_DB; db -= 10.0f)
         {
-            slowAverager.add(0);
-            peakAverager.add(0);
+            auto y = juce::jmap(db, SPECTRUM_MIN_DB, 0.0f, static_cast<float>(plot.getBottom()), static_cast<float>(plot.getY()));
+            gl.drawHorizontalLine(juce::roundToInt(y), static_cast<float>(plot.getX()), static_cast<float>(plot.getRight()));
         }
-        else
-        {
-            float processedSample = filters[0].processSample(bufferData[0][i] * bufferData[1][i]) / sqrt;
 
-            slowAverager.add(processedSample);
-            peakAverager.add(processedSample);
+        gl.setFont(10);
+        auto logRange = std::log(SPECTRUM_MAX_HZ / SPECTRUM_MIN_HZ);
+        for (float hz : { 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f, 10000.0f })
+        {
+            auto x = plot.getX() + juce::roundToInt(plot.getWidth() * std::log(hz / SPECTRUM_MIN_HZ) / logRange);
+            gl.setColour(juce::Colours::darkgrey);
+            gl.drawVerticalLine(x, static_cast<float>(plot.getY()), static_cast<float>(plot.getBottom()));
+            gl.setColour(juce::Colours::white);
+            gl.drawText(hz < 1000.0f ? juce::String(hz, 0) : juce::String(hz / 1000.0f, 0) + "k",
+                        x - 20, plot.getBottom(), 40, labelHeight, juce::Justification::centred);
         }
-    }
-    repaint();
+    });
+
+    g.drawImageAt(bars, plot.getX(), plot.getY());
 }
 //==============================================================================
-StereoImageMeter::StereoImageMeter(juce::AudioBuffer<float>& buffer_, double sampleRate) :
-goniometer(buffer_),
-correlationMeter(buffer_, sampleRate)
+StereoImageMeter::StereoImageMeter()
 {
     addAndMakeVisible(goniometer);
     addAndMakeVisible(correlationMeter);
@@ -772,10 +1006,10 @@ void StereoImageMeter::setGoniometerScale(float coefficient)
     goniometer.setScale(coefficient);
 }
 
-void StereoImageMeter::update()
+void StereoImageMeter::update(const AnalysisResults& results)
 {
-    correlationMeter.update();
-    goniometer.repaint();
+    correlationMeter.update(results.peakCorrelation, results.slowCorrelation);
+    goniometer.update(results);
 }
 
 void StereoImageMeter::resized()
@@ -786,6 +1020,122 @@ void StereoImageMeter::resized()
     correlationMeter.setBounds(goniometer.getBounds().withY(goniometer.getBottom() - 10).withHeight(25));
 }
 //==============================================================================
+juce::String LoudnessMeter::formatLevel(float db)
+{
+    return std::isfinite(db) ? juce::String(db, 1) : juce::String("-inf");
+}
+
+void LoudnessMeter::update(const LoudnessEngine::Values& values, float maxTruePeak, int numTruePeakOvers)
+{
+    juce::StringArray newLines{ "M  " + formatLevel(values.momentary) + " LUFS",
+                                "S  " + formatLevel(values.shortTerm) + " LUFS",
+                                "I  " + formatLevel(values.integrated) + " LUFS",
+                                "LRA  " + juce::String(values.range, 1) + " LU",
+                                "TP  " + formatLevel(juce::Decibels::gainToDecibels(maxTruePeak, -std::numeric_limits<float>::infinity())) + " dBTP",
+                                "Overs  " + juce::String(numTruePeakOvers) };
+
+    if (newLines != lines)
+    {
+        lines = newLines;
+        overLimit = numTruePeakOvers > 0;
+        markDirty(*this);
+    }
+}
+
+void LoudnessMeter::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds();
+
+    g.setColour(juce::Colours::black);
+    g.fillRect(bounds);
+    g.setColour(juce::Colours::darkgrey);
+    g.drawRect(bounds);
+
+    g.setFont(12);
+
+    bounds = bounds.reduced(4, 2);
+    auto lineHeight = bounds.getHeight() / lines.size();
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        // the true peak lines turn red once anything crossed the limit
+        g.setColour(i >= 4 && overLimit ? juce::Colours::red : juce::Colours::white);
+        g.drawText(lines[i], bounds.removeFromTop(lineHeight), juce::Justification::centredLeft);
+    }
+}
+
+void LoudnessMeter::mouseDown(const juce::MouseEvent& e)
+{
+    if (onReset)
+        onReset();
+}
+//==============================================================================
+void DiagnosticsView::update(const RealtimeDiagnostics::Snapshot& snapshot)
+{
+    juce::StringArray newLines{ "over " + juce::String(snapshot.recordOverruns + snapshot.sampleOverruns)
+                                    + "  under " + juce::String(snapshot.underruns) };
+
+    if (snapshot.checksEnabled)
+    {
+        newLines.add("alloc " + juce::String(snapshot.heapOperations) + "  stall " + juce::String(snapshot.stalls));
+        newLines.add("load p99 " + juce::String(snapshot.loadP99, 0) + "%");
+        newLines.add("worst " + juce::String(snapshot.worstLoad, 0) + "%");
+    }
+    else
+    {
+        newLines.add("RT checks off");
+        newLines.add("");
+        newLines.add("");
+    }
+
+    auto problems = snapshot.recordOverruns + snapshot.sampleOverruns + snapshot.heapOperations + snapshot.stalls > 0
+                    || snapshot.worstLoad >= 100.0f;
+
+    if (newLines != lines || problems != hasProblems)
+    {
+        lines = newLines;
+        hasProblems = problems;
+        markDirty(*this);
+    }
+}
+
+void DiagnosticsView::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds();
+
+    g.setColour(juce::Colours::black);
+    g.fillRect(bounds);
+    g.setColour(hasProblems ? juce::Colours::red : juce::Colours::darkgrey);
+    g.drawRect(bounds);
+
+    g.setFont(12);
+    g.setColour(juce::Colours::white);
+
+    bounds = bounds.reduced(4, 2);
+    auto lineHeight = bounds.getHeight() / lines.size();
+    for (auto& line : lines)
+        g.drawText(line, bounds.removeFromTop(lineHeight), juce::Justification::centredLeft);
+}
+
+void DiagnosticsView::mouseUp(const juce::MouseEvent& e)
+{
+    if (e.getNumberOfClicks() == 1)
+        startTimer(juce::MouseEvent::getDoubleClickTimeout());
+}
+
+void DiagnosticsView::mouseDoubleClick(const juce::MouseEvent& e)
+{
+    stopTimer();
+    if (onReset)
+        onReset();
+}
+
+void DiagnosticsView::timerCallback()
+{
+    stopTimer();
+    if (onDump)
+        onDump();
+}
+//==============================================================================
 PFMCPP_Project10AudioProcessorEditor::PFMCPP_Project10AudioProcessorEditor (PFMCPP_Project10AudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
@@ -797,12 +1147,28 @@ PFMCPP_Project10AudioProcessorEditor::PFMCPP_Project10AudioProcessorEditor (PFMC
     addAndMakeVisible(histogramContainer);
 
     addAndMakeVisible(stereoImageMeter);
+    addAndMakeVisible(spectrumAnalyser);
+    addAndMakeVisible(loudnessMeter);
+    loudnessMeter.onReset = [this]()
+    {
+        audioProcessor.resetLoudness();
+        audioProcessor.analyser.resetTruePeakHold();
+    };
+
+    addAndMakeVisible(diagnosticsView);
+    diagnosticsView.onDump = [this]()
+    {
+        auto report = audioProcessor.diagnostics.dump();
+        juce::SystemClipboard::copyTextToClipboard(report);
+    };
+    diagnosticsView.onReset = [this]() { audioProcessor.diagnostics.requestReset(); };
 
     addAndMakeVisible(meterView);
     addAndMakeVisible(holdDuration);
     addAndMakeVisible(decayRate);
     addAndMakeVisible(avgDuration);
     addAndMakeVisible(histogramView);
+    addAndMakeVisible(histogramMode);
 
     addAndMakeVisible(resetHold);
     addAndMakeVisible(enableHold);
@@ -835,13 +1201,10 @@ PFMCPP_Project10AudioProcessorEditor::PFMCPP_Project10AudioProcessorEditor (PFMC
         peakStereoMeter.showMeters(meterView.getText());
     };
 
-    juce::StringArray durationKeys{ "0.0s", "0.5s", "2.0s", "4.0s", "6.0s", "inf" };
-    holdDuration.addItemList(durationKeys, 1);
-    holdDuration.setSelectedItemIndex(1);
+    holdDuration.addItemList(getChoices("holdTime"), 1);
     holdDuration.onChange = [this]()
     {
-        juce::Array<int> durationMs{ 0, 500, 2000, 4000, 6000, std::numeric_limits<int>::max() };
-        int newDuration{ durationMs[holdDuration.getSelectedItemIndex()] };
+        auto newDuration = PFMCPP_Project10AudioProcessor::getHoldTimeMs(holdDuration.getSelectedItemIndex());
 
         if (newDuration == std::numeric_limits<int>::max()) { resetHold.setVisible(true); }
         else { resetHold.setVisible(false); }
@@ -849,28 +1212,16 @@ PFMCPP_Project10AudioProcessorEditor::PFMCPP_Project10AudioProcessorEditor (PFMC
         peakStereoMeter.setHoldDuration(newDuration);
     };
 
-    juce::StringArray decayKeys{ "-3.0dB/s", "-6.0dB/s", "-12.0dB/s", "-24.0dB/s", "-36.0dB/s" };
-    decayRate.addItemList(decayKeys, 1);
-    decayRate.setSelectedItemIndex(1);
+    decayRate.addItemList(getChoices("decayRate"), 1);
     decayRate.onChange = [this]()
     {
-        juce::Array<float> decayRates{ 3.0f, 6.0f, 12.0f, 24.0f, 36.0f };
-        float dbPerSec = decayRates[decayRate.getSelectedItemIndex()];
+        auto dbPerSec = PFMCPP_Project10AudioProcessor::getDecayRateDbPerSecond(decayRate.getSelectedItemIndex());
         rmsStereoMeter.setDecayRate(dbPerSec);
         peakStereoMeter.setDecayRate(dbPerSec);
     };
 
-    juce::StringArray avgDurationKeys{ "100ms", "250ms", "500ms", "1000ms", "2000ms" };
-    avgDuration.addItemList(avgDurationKeys, 1);
-    avgDuration.setSelectedItemIndex(2);
-    avgDuration.onChange = [this]()
-    {
-        juce::Array<float> avgDurations{ 0.10f, 0.25f, 0.50f, 1.0f, 2.0f };
-        float newDuration{ avgDurations[avgDuration.getSelectedItemIndex()] * ValueHolderBase::frameRate };
-        
-        rmsStereoMeter.setAverageDuration(newDuration);
-        peakStereoMeter.setAverageDuration(newDuration);
-    };
+    // only the audio thread needs the averaging time, it reads the parameter itself
+    avgDuration.addItemList(getChoices("averageTime"), 1);
 
     juce::StringArray histogramKeys{ "Stacked", "Side-by-Side" };
     histogramView.addItemList(histogramKeys, 1);
@@ -881,6 +1232,22 @@ PFMCPP_Project10AudioProcessorEditor::PFMCPP_Project10AudioProcessorEditor (PFMC
         else { histogramContainer.setFlex(juce::FlexBox::Direction::row, histogramContainer.getLocalBounds()); }
     };
 
+    juce::StringArray histogramModeKeys{ "Scrolling", "Distribution", "Distribution (10s decay)", "Distribution (30s window)" };
+    histogramMode.addItemList(histogramModeKeys, 1);
+    histogramMode.setSelectedItemIndex(0);
+    histogramMode.onChange = [this]()
+    {
+        auto index = histogramMode.getSelectedItemIndex();
+        bool showDistribution = index > 0;
+
+        if (showDistribution) { audioProcessor.analyser.setDistributionMode(index - 1); }
+        histogramContainer.rmsHistogram.setDistributionView(showDistribution);
+        histogramContainer.peakHistogram.setDistributionView(showDistribution);
+    };
+
+    histogramContainer.rmsHistogram.onDistributionClear = [this]() { audioProcessor.analyser.resetDistributions(); };
+    histogramContainer.peakHistogram.onDistributionClear = [this]() { audioProcessor.analyser.resetDistributions(); };
+
     resetHold.setVisible(false);
     resetHold.onClick = [this]()
     {
@@ -888,7 +1255,6 @@ PFMCPP_Project10AudioProcessorEditor::PFMCPP_Project10AudioProcessorEditor (PFMC
         peakStereoMeter.resetHeldValue();
     };
 
-    enableHold.setToggleState(true, juce::NotificationType::sendNotification);
     enableHold.onStateChange = [this]()
     {
         rmsStereoMeter.toggleTicks(enableHold.getToggleState());
@@ -901,24 +1267,37 @@ PFMCPP_Project10AudioProcessorEditor::PFMCPP_Project10AudioProcessorEditor (PFMC
         stereoImageMeter.setGoniometerScale(goniometerScale.getValue());
     };
 
-    decayRate.getSelectedIdAsValue().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Decay Time"), nullptr));
-    avgDuration.getSelectedIdAsValue().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Average Time"), nullptr));
-    meterView.getSelectedIdAsValue().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Meter View Mode"), nullptr));
-    holdDuration.getSelectedIdAsValue().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Hold Time"), nullptr));
-    histogramView.getSelectedIdAsValue().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Histogram View"), nullptr));
-
-    enableHold.getToggleStateValue().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Enable Hold"), nullptr));
+    // the attachments push the current values through the callbacks above
+    auto& apvts = audioProcessor.apvts;
+    rmsThresholdAttachment = std::make_unique<SliderAttachment>(apvts, "rmsThreshold", rmsStereoMeter.thresholdSlider);
+    peakThresholdAttachment = std::make_unique<SliderAttachment>(apvts, "peakThreshold", peakStereoMeter.thresholdSlider);
+    holdDurationAttachment = std::make_unique<ComboBoxAttachment>(apvts, "holdTime", holdDuration);
+    decayRateAttachment = std::make_unique<ComboBoxAttachment>(apvts, "decayRate", decayRate);
+    avgDurationAttachment = std::make_unique<ComboBoxAttachment>(apvts, "averageTime", avgDuration);
+    enableHoldAttachment = std::make_unique<ButtonAttachment>(apvts, "enableHold", enableHold);
 
-    goniometerScale.getValueObject().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Goniometer Scale"), nullptr));
-    rmsStereoMeter.thresholdSlider.getValueObject().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("RMS Threshold"), nullptr));
-    peakStereoMeter.thresholdSlider.getValueObject().referTo(audioProcessor.valueTree.getPropertyAsValue(juce::Identifier("Peak Threshold"), nullptr));
+    referToViewState();
+    apvts.state.addListener(this);
 
+    // full analysis only while someone looks at it
+    audioProcessor.analyser.setEditorVisible(true);
     startTimerHz(ValueHolderBase::frameRate);
-    setSize (700, 570);
+    setNumChannels(juce::jlimit(1, MAX_CHANNELS, audioProcessor.getTotalNumInputChannels()));
 }
 
 PFMCPP_Project10AudioProcessorEditor::~PFMCPP_Project10AudioProcessorEditor()
 {
+    audioProcessor.apvts.state.removeListener(this);
+    audioProcessor.analyser.setEditorVisible(false);
+}
+
+juce::StringArray PFMCPP_Project10AudioProcessorEditor::getChoices(const juce::String& parameterID) const
+{
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter(parameterID)))
+        return choice->choices;
+
+    jassertfalse;
+    return {};
 }
 
 void PFMCPP_Project10AudioProcessorEditor::paint (juce::Graphics& g)
@@ -936,40 +1315,91 @@ void PFMCPP_Project10AudioProcessorEditor::paint (juce::Graphics& g)
 
 void PFMCPP_Project10AudioProcessorEditor::timerCallback()
 {
-    if (audioProcessor.audioBufferFifo.pull(buffer))
+    // all analysis happens on the shared analysis workers, the timer only hands the
+    // newest results to the components
+    if (audioProcessor.analyser.pullResults())
     {
-        while (audioProcessor.audioBufferFifo.pull(buffer)) { }
+        auto& results = audioProcessor.analyser.getResults();
 
-        auto magDbLeft = juce::Decibels::gainToDecibels(buffer.getMagnitude(0, 0, buffer.getNumSamples()), NEGATIVE_INFINITY);
-        auto magDbRight = juce::Decibels::gainToDecibels(buffer.getMagnitude(1, 0, buffer.getNumSamples()), NEGATIVE_INFINITY);
+        if (results.hasLevels)
+        {
+            if (results.numChannels != rmsStereoMeter.getNumChannels())
+                setNumChannels(results.numChannels);
 
-        auto rmsDbLeft = juce::Decibels::gainToDecibels(buffer.getRMSLevel(0, 0, buffer.getNumSamples()), NEGATIVE_INFINITY);
-        auto rmsDbRight = juce::Decibels::gainToDecibels(buffer.getRMSLevel(1, 0, buffer.getNumSamples()), NEGATIVE_INFINITY);
+            rmsStereoMeter.update(results.rmsDb, results.averageDb);
+            peakStereoMeter.update(results.peakDb, results.ppmDb);
 
-        magDbLeft = juce::jlimit(NEGATIVE_INFINITY, MAX_DECIBELS, magDbLeft);
-        magDbRight = juce::jlimit(NEGATIVE_INFINITY, MAX_DECIBELS, magDbRight);
+            histogramContainer.rmsHistogram.update(results.rmsHistogramDb);
+            histogramContainer.peakHistogram.update(results.peakHistogramDb);
 
-        rmsDbLeft = juce::jlimit(NEGATIVE_INFINITY, MAX_DECIBELS, rmsDbLeft);
-        rmsDbRight = juce::jlimit(NEGATIVE_INFINITY, MAX_DECIBELS, rmsDbRight);
+            histogramContainer.rmsHistogram.updateDistribution(results.rmsDistribution);
+            histogramContainer.peakHistogram.updateDistribution(results.peakDistribution);
+        }
 
-        rmsStereoMeter.update(rmsDbLeft, rmsDbRight);
-        peakStereoMeter.update(magDbLeft, magDbRight);
+        stereoImageMeter.update(results);
+        spectrumAnalyser.update(results);
+        loudnessMeter.update(results.loudness, results.maxTruePeak, results.numTruePeakOvers);
+    }
+    else if (audioProcessor.meterRecordFifo.getNumAvailableForReading() > 0
+             && audioProcessor.analyser.getMillisecondsSinceLastDrain() > 2u * AnalysisService::getTickIntervalMs())
+    {
+        // audio is waiting and its pass is over a whole interval late; audio
+        // that merely arrived after the last pass is not an underrun
+        audioProcessor.diagnostics.countUnderrun();
+    }
 
-        histogramContainer.rmsHistogram.update((rmsDbLeft + rmsDbRight) / 2);
-        histogramContainer.peakHistogram.update((magDbLeft + magDbRight) / 2);
+    diagnosticsView.update(audioProcessor.diagnostics.getSnapshot());
 
-        stereoImageMeter.update();
-    }
+    // whatever changed this frame, including from the controls in between,
+    // goes out as a handful of merged rectangles
+    if (dirtyArea.isEmpty())
+        return;
+
+    dirtyArea.consolidate();
+    for (auto& area : dirtyArea)
+        repaint(area);
+    dirtyArea.clear();
+}
+
+void PFMCPP_Project10AudioProcessorEditor::markDirty(juce::Component& component, juce::Rectangle<int> area)
+{
+    dirtyArea.add(getLocalArea(&component, area));
+}
+
+void PFMCPP_Project10AudioProcessorEditor::referToViewState()
+{
+    auto& state = audioProcessor.apvts.state;
+    meterView.getSelectedIdAsValue().referTo(state.getPropertyAsValue(juce::Identifier("Meter View Mode"), nullptr));
+    histogramView.getSelectedIdAsValue().referTo(state.getPropertyAsValue(juce::Identifier("Histogram View"), nullptr));
+    histogramMode.getSelectedIdAsValue().referTo(state.getPropertyAsValue(juce::Identifier("Histogram Mode"), nullptr));
+    goniometerScale.getValueObject().referTo(state.getPropertyAsValue(juce::Identifier("Goniometer Scale"), nullptr));
+}
+
+void PFMCPP_Project10AudioProcessorEditor::valueTreeRedirected(juce::ValueTree&)
+{
+    // setStateInformation() swapped in a new tree, the old values point at the discarded one
+    referToViewState();
+}
+
+void PFMCPP_Project10AudioProcessorEditor::setNumChannels(int numChannels)
+{
+    rmsStereoMeter.setNumChannels(numChannels);
+    peakStereoMeter.setNumChannels(numChannels);
+
+    // the centre section keeps its width, the meters grow with the channel count
+    setSize(530 + rmsStereoMeter.getPreferredWidth() + peakStereoMeter.getPreferredWidth(), 730);
 }
 
 void PFMCPP_Project10AudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
 
+    spectrumAnalyser.setBounds(bounds.removeFromBottom(160));
+    audioProcessor.analyser.setSpectrumColumns(spectrumAnalyser.getNumColumns());
     histogramContainer.setBounds(bounds.removeFromBottom(240));
 
-    rmsStereoMeter.setBounds(bounds.removeFromLeft(85));
-    peakStereoMeter.setBounds(bounds.removeFromRight(85));
+    rmsStereoMeter.setBounds(bounds.removeFromLeft(rmsStereoMeter.getPreferredWidth()));
+    peakStereoMeter.setBounds(bounds.removeFromRight(peakStereoMeter.getPreferredWidth()));
 
     stereoImageMeter.setBounds(bounds);
 
@@ -980,5 +1410,8 @@ void PFMCPP_Project10AudioProcessorEditor::resized()
     decayRate.setBounds(enableHold.getBounds().translated(0, 30));
     avgDuration.setBounds(decayRate.getBounds().translated(0, 30));
     histogramView.setBounds(avgDuration.getBounds().translated(0, 30));
+    histogramMode.setBounds(histogramView.getBounds().translated(0, 30));
     goniometerScale.setBounds(500, 10, 100, 100);
+    loudnessMeter.setBounds(stereoImageMeter.getRight() - 115, 120, 105, 96);
+    diagnosticsView.setBounds(loudnessMeter.getX(), loudnessMeter.getBottom() + 6, 105, 66);
 }
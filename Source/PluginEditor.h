@@ -11,8 +11,7 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
-#define NEGATIVE_INFINITY -66.0f
-#define MAX_DECIBELS 12.0f
+#define SPECTRUM_MIN_DB -90.0f
 //==============================================================================
 /**
 */
@@ -25,63 +24,75 @@ struct NewLNF : juce::LookAndFeel_V4
                           const juce::Slider::SliderStyle style, juce::Slider& slider) override;
 };
 //==============================================================================
-struct ValueHolderBase : juce::Timer
+/**
+    Implemented by the editor. Components report the area that changed during
+    a frame here instead of repainting themselves, and the editor merges all of
+    them into one consolidated repaint per frame.
+*/
+struct DirtyAreaCollector
 {
-    ValueHolderBase();
-    virtual ~ValueHolderBase();
-
-    virtual void updateHeldValue(float v) = 0;
-    virtual void timerCallback() override;
-    virtual void timerCallbackImpl() = 0;
-    void setThreshold(float th);
-    void setHoldTime(int ms);
-    float getCurrentValue() const;
-    bool getIsOverThreshold() const;
-    float getThreshold() const;
-    bool getInfiniteHold() const;
-
-    juce::int64 getPeakTime() const;
-    juce::int64 getHoldTime() const;
-    static juce::int64 getNow();
-
-    static int frameRate;
-
-protected:
-    bool infiniteHold{ false };
-    float threshold = 0.0f;
-    float currentValue = NEGATIVE_INFINITY;
-    juce::int64 peakTime = 0;   // 0 to prevent red textmeter at launch
-    juce::int64 holdTime = 2000;
+    virtual ~DirtyAreaCollector() = default;
+    /** area is in component's own coordinates. */
+    virtual void markDirty(juce::Component& component, juce::Rectangle<int> area) = 0;
 };
+
+/** Hands component to the nearest DirtyAreaCollector, or repaints it directly without one. */
+void markDirty(juce::Component& component);
+void markDirty(juce::Component& component, juce::Rectangle<int> area);
 //==============================================================================
-struct ValueHolder : ValueHolderBase
+/**
+    The parts of a component that don't change from frame to frame, rendered
+    once into an image at the display's pixel scale. The image is rebuilt when
+    the bounds, the scale or the caller's variant key change, otherwise paint()
+    only blits it.
+*/
+struct CachedLayer
 {
-    ValueHolder();
-    ~ValueHolder();
-    void timerCallbackImpl() override;
-    void updateHeldValue(float v) override;
-    float getHeldValue() const;
-    float getValue() const;
+    template<typename DrawFunction>
+    void draw(juce::Graphics& g, juce::Rectangle<int> bounds, juce::int64 variant, DrawFunction&& drawLayer)
+    {
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (image.isNull() || bounds != cachedBounds || scale != cachedScale || variant != cachedVariant)
+        {
+            cachedBounds = bounds;
+            cachedScale = scale;
+            cachedVariant = variant;
+
+            image = juce::Image(juce::Image::PixelFormat::ARGB,
+                                juce::jmax(1, juce::roundToInt(bounds.getWidth() * scale)),
+                                juce::jmax(1, juce::roundToInt(bounds.getHeight() * scale)),
+                                true, juce::SoftwareImageType());
+            juce::Graphics layer(image);
+            layer.addTransform(juce::AffineTransform::scale(scale).translated(-bounds.getX() * scale, -bounds.getY() * scale));
+            drawLayer(layer);
+        }
+
+        g.drawImageTransformed(image, juce::AffineTransform::scale(1.0f / scale).translated(bounds.getPosition().toFloat()));
+    }
+
+    void invalidate() { image = {}; }
 
 private:
-    float heldValue = NEGATIVE_INFINITY;
+    juce::Image image;
+    juce::Rectangle<int> cachedBounds;
+    float cachedScale{ 0.0f };
+    juce::int64 cachedVariant{ 0 };
 };
 //==============================================================================
-struct DecayingValueHolder : ValueHolderBase
+/**
+    One animation clock shared by every hold/decay object of the editor.
+    It runs on wall-clock time, ticks all registered holders in one batch and
+    stops itself as soon as none of them has anything left to animate.
+*/
+struct FrameClock : MeterClock, juce::Timer
 {
-    DecayingValueHolder();
-    ~DecayingValueHolder();
-
-    void timerCallbackImpl() override;
-    void updateHeldValue(float v) override;
+    ~FrameClock() override;
 
-    void setDecayRate(float dbPerSec);
-
-private:
-    float decayRatePerFrame{ 0 };
-    float decayRateMultiplier{ 1 };
-
-    void resetDecayRateMultiplier();
+    juce::int64 getNow() const override;
+    /** Starts ticking if the clock was idle. */
+    void wake() override;
+    void timerCallback() override;
 };
 //==============================================================================
 struct TextMeter : juce::Component
@@ -95,11 +106,20 @@ struct TextMeter : juce::Component
 
 private:
     float cachedValueDb;
-    ValueHolder valueHolder;
+    juce::SharedResourcePointer<FrameClock> frameClock;
+    ValueHolder valueHolder{ frameClock.getObject() };
+
+    // what is on screen, repaints only happen when this changes
+    juce::String displayedText;
+    bool displayedOverThreshold{ false };
+
+    juce::String getDisplayText() const;
+    void repaintIfChanged();
 };
 //==============================================================================
 struct Meter : juce::Component
 {
+    Meter();
     void paint(juce::Graphics& g) override;
     void update(float dbLevel);
     void setThreshold(float threshold);
@@ -109,9 +129,27 @@ struct Meter : juce::Component
     void resetHeldValue();
 
 private:
+    struct DisplayState
+    {
+        int peakY{ 0 }, thresholdY{ 0 }, tickY{ 0 };
+        bool overThreshold{ false };
+        bool showTicks{ true };
+
+        bool operator==(const DisplayState& other) const
+        {
+            return peakY == other.peakY && thresholdY == other.thresholdY && tickY == other.tickY
+                && overThreshold == other.overThreshold && showTicks == other.showTicks;
+        }
+    };
+
     bool showTicks{ true };
-    float peakDb;
-    DecayingValueHolder decayingValueHolder;
+    float peakDb{ NEGATIVE_INFINITY };
+    juce::SharedResourcePointer<FrameClock> frameClock;
+    DecayingValueHolder decayingValueHolder{ frameClock.getObject() };
+    DisplayState displayedState;
+
+    DisplayState getDisplayState() const;
+    void repaintIfChanged();
 };
 //==============================================================================
 struct Tick
@@ -136,7 +174,8 @@ struct MacroMeter : juce::Component
     MacroMeter(int orientation);
     ~MacroMeter();
     void resized() override;
-    void update(float level);
+    /** level drives the peak bar and the text, averageLevel the wide bar. */
+    void update(float level, float averageLevel);
     bool getOrientation() const;
     juce::Rectangle<int> getAvgMeterBounds() const;
     int getTextMeterHeight() const;
@@ -146,20 +185,22 @@ struct MacroMeter : juce::Component
     void setHoldDuration(int newDuration);
     void resetHeldValue();
     void setDecayRate(float dbPerSec);
-    void setAvgDuration(float avgDuration);
 
 private:
     int orientation;
     TextMeter textMeter;
     Meter peakMeter, avgMeter;
-    Averager<float> averager;
 };
 //==============================================================================
 struct StereoMeter : juce::Component
 {
     StereoMeter(juce::String labelName, juce::String labelText);
     ~StereoMeter();
-    void update(float levelLeft, float levelRight);
+    /** Rebuilds the meter columns, the first half sits left of the scale. */
+    void setNumChannels(int numChannels);
+    int getNumChannels() const;
+    int getPreferredWidth() const;
+    void update(const std::array<float, MAX_CHANNELS>& levels, const std::array<float, MAX_CHANNELS>& averageLevels);
     void resized() override;
     void setThreshold(float threshold);
     void showMeters(const juce::String& meter);
@@ -167,15 +208,24 @@ struct StereoMeter : juce::Component
     void setHoldDuration(int newDuration);
     void resetHeldValue();
     void setDecayRate(float dbPerSec);
-    void setAverageDuration(float avgDuration);
 
     juce::Slider thresholdSlider{ juce::Slider::SliderStyle::LinearVertical,
                                   juce::Slider::TextEntryBoxPosition::NoTextBox };
 
 private:
-    MacroMeter leftMacroMeter{ Left }, rightMacroMeter{ Right };
+    juce::OwnedArray<MacroMeter> macroMeters;
     DbScale dbScale;
     juce::Label label;
+    juce::String labelName, labelText;
+
+    // kept so that columns created later start with the current settings
+    float threshold{ 0.0f };
+    juce::String meterMode{ "BOTH" };
+    bool showTicks{ true };
+    int holdDuration{ 500 };
+    float decayRate{ 3.0f };
+
+    int getNumLeftColumns() const;
 };
 //==============================================================================
 struct Histogram : juce::Component
@@ -186,18 +236,36 @@ struct Histogram : juce::Component
     void resized() override;
     void mouseDown(const juce::MouseEvent& e) override;
     void update(float value);
+    void updateDistribution(const AnalysisResults::Distribution& newDistribution);
+    /** Switches between the scrolling level plot and the level distribution. */
+    void setDistributionView(bool shouldShowDistribution);
     void setThreshold(float newThreshold);
     bool isOverThreshold() const;
 
+    /** Called on click in distribution view, the distribution lives in the processor's analyser. */
+    std::function<void()> onDistributionClear;
+
 private:
+    // one value per plot column, the write index is also the oldest column
     ReadAllAfterWriteCircularBuffer<float> buffer{ NEGATIVE_INFINITY };
-    juce::Path path;
+    // ring of columns in the same order as buffer, drawn in two parts so an
+    // update only touches the newest column
+    juce::Image plot;
+
+    juce::Rectangle<int> getPlotBounds() const;
+    void drawColumn(int x, float value, float previousValue);
+    void redrawPlot();
+    void paintDistribution(juce::Graphics& g, juce::Rectangle<int> bounds);
+
+    bool showDistribution{ false };
+    AnalysisResults::Distribution distribution;
 
-    void displayPath(juce::Graphics& g, juce::Rectangle<float> bounds);
+    // silence scrolls as identical empty columns, nothing needs repainting
+    // while every column on screen is empty
+    int numNonEmptyColumns{ 0 };
+    // bar heights and percentile positions in pixels, as last painted
+    std::array<int, AnalysisResults::numDistributionBins + 3> displayedDistribution{};
 
-    static juce::Path buildPath(juce::Path& p,
-                                ReadAllAfterWriteCircularBuffer<float>& buffer,
-                                juce::Rectangle<float> bounds);
     const juce::String title;
     float threshold{ 0.0f };
 };
@@ -213,15 +281,15 @@ struct HistogramContainer : juce::Component
 //==============================================================================
 struct Goniometer : juce::Component
 {
-    Goniometer(juce::AudioBuffer<float>& buffer);
     void paint(juce::Graphics& g) override;
     void resized() override;
     void setScale(float& coefficient);
+    void update(const AnalysisResults& results);
 
 private:
-    juce::AudioBuffer<float>& buffer;
-    juce::AudioBuffer<float> internalBuffer;
-    juce::Path p;
+    // persistent trace, every sample brightens one pixel and the whole image
+    // fades a little each frame
+    juce::Image phosphor;
     juce::Point<float> center;
     juce::Array<juce::String> chars { "+S", "L", "M", "R", "-S" };
     juce::Image bkgd;
@@ -229,30 +297,68 @@ private:
     float scaleCoefficient{ 1.0f };
     float conversionCoefficient{ juce::Decibels::decibelsToGain(-3.0f) };
 
+    static constexpr int phosphorDecay = 200;       // per frame, out of 256
+    static constexpr int phosphorIntensity = 96;
+    // frames after which a trace that stays on one pixel has faded to a still image
+    static constexpr int framesToSettle = 24;
+
+    int framesUntilSettled{ 0 };
+    juce::Point<int> lastSinglePixel{ -1, -1 };
+
     void drawBackground();
+    void fadePhosphor(juce::Image::BitmapData& pixels);
+    void plotPoints(juce::Image::BitmapData& pixels, const AnalysisResults& results);
+    juce::Point<int> mapToPixel(juce::Point<float> point, int diameter) const;
+    /** True when every point lands on the single pixel the previous frame landed on. */
+    bool isStill(const AnalysisResults& results);
 };
 //==============================================================================
 struct CorrelationMeter : juce::Component
 {
-    CorrelationMeter(juce::AudioBuffer<float>& buf, double sampleRate);
-    void update();
+    void update(float peakCorrelation, float slowCorrelation);
     void paint(juce::Graphics& g) override;
     void fillMeter(juce::Graphics& g, juce::Rectangle<float>& bounds, float value, float centerX);
 
 private:
-    juce::AudioBuffer<float>& buffer;
-    using FilterType = juce::dsp::FIR::Filter<float>;
-    std::array<FilterType, 3> filters;
     juce::Array<juce::String> chars{ "-1", "+1" };
 
-    Averager<float> slowAverager{ 1024 * 3, 0 }, peakAverager{ 512, 0 };
+    float peak{ 0.0f }, slow{ 0.0f };
+    int displayedPeakX{ -1 }, displayedSlowX{ -1 };
+    static constexpr int labelWidth = 25;
+    // outlines and labels
+    CachedLayer outline;
+
+    juce::Rectangle<float> getMeterBounds() const;
+};
+//==============================================================================
+/**
+    Log-frequency spectrum with one column per pixel. The bars live in an
+    image of their own and each update only redraws the part of a column
+    that grew or shrank, paint() just blits the grid and that image.
+*/
+struct SpectrumAnalyser : juce::Component
+{
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void update(const AnalysisResults& results);
+    int getNumColumns() const;
+
+private:
+    static constexpr int labelHeight = 14;
+
+    juce::Image bars;
+    std::array<int, SpectrumEngine::maxColumns> displayedY;
+    // background, frequency and level lines
+    CachedLayer grid;
+
+    juce::Rectangle<int> getPlotBounds() const;
 };
 //==============================================================================
 struct StereoImageMeter : juce::Component
 {
-    StereoImageMeter(juce::AudioBuffer<float>& buffer_, double sampleRate);
+    StereoImageMeter();
     void resized() override;
-    void update();
+    void update(const AnalysisResults& results);
     void setGoniometerScale(float coefficient);
 
 private:
@@ -260,8 +366,48 @@ private:
     CorrelationMeter correlationMeter;
 };
 //==============================================================================
+/**
+    Momentary, short-term, integrated loudness and range, plus the true peak
+    max-hold and over count. A click restarts integration and the hold.
+*/
+struct LoudnessMeter : juce::Component
+{
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& e) override;
+    void update(const LoudnessEngine::Values& values, float maxTruePeak, int numTruePeakOvers);
+
+    std::function<void()> onReset;
+
+private:
+    // the text as painted, one decimal
+    juce::StringArray lines{ "", "", "", "", "", "" };
+    bool overLimit{ false };
+
+    static juce::String formatLevel(float db);
+};
+//==============================================================================
+/** The audio thread's RealtimeDiagnostics at a glance. */
+struct DiagnosticsView : juce::Component, private juce::Timer
+{
+    void paint(juce::Graphics& g) override;
+    void mouseUp(const juce::MouseEvent& e) override;
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
+    void update(const RealtimeDiagnostics::Snapshot& snapshot);
+
+    std::function<void()> onDump, onReset;      // click, double click
+
+private:
+    // a click only dumps once it can no longer become a double click
+    void timerCallback() override;
+
+    juce::StringArray lines{ "", "", "", "" };
+    bool hasProblems{ false };
+};
+//==============================================================================
 class PFMCPP_Project10AudioProcessorEditor : public juce::AudioProcessorEditor,
-    public juce::Timer
+    public juce::Timer,
+    public DirtyAreaCollector,
+    private juce::ValueTree::Listener
 {
 public:
     PFMCPP_Project10AudioProcessorEditor(PFMCPP_Project10AudioProcessor&);
@@ -271,12 +417,22 @@ public:
     void paint(juce::Graphics&) override;
     void resized() override;
     void timerCallback() override;
+    void markDirty(juce::Component& component, juce::Rectangle<int> area) override;
 
 private:
+    juce::RectangleList<int> dirtyArea;
+
+    /** Points the view controls at the properties of the current apvts.state. */
+    void referToViewState();
+    void valueTreeRedirected(juce::ValueTree& tree) override;
+
+    void setNumChannels(int numChannels);
+    /** The item texts of a choice parameter, for the combo box attached to it. */
+    juce::StringArray getChoices(const juce::String& parameterID) const;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     PFMCPP_Project10AudioProcessor& audioProcessor;
-    juce::AudioBuffer<float> buffer;
     juce::Image reference;
     NewLNF newLNF;
     StereoMeter rmsStereoMeter{ "RMS", "L RMS R" },
@@ -285,13 +441,17 @@ private:
     //Histogram rmsHistogram{ "RMS" }, peakHistogram{ "PEAK" };
     HistogramContainer histogramContainer;
 
-    StereoImageMeter stereoImageMeter{ buffer, audioProcessor.getSampleRate() };
+    StereoImageMeter stereoImageMeter;
+    SpectrumAnalyser spectrumAnalyser;
+    LoudnessMeter loudnessMeter;
+    DiagnosticsView diagnosticsView;
 
     juce::ComboBox meterView{ "Meter View" };
     juce::ComboBox holdDuration{ "Hold Duration" };
     juce::ComboBox decayRate{ "Decay Rate" };
     juce::ComboBox avgDuration{ "Average Duration" };
     juce::ComboBox histogramView{ "Histogram View" };
+    juce::ComboBox histogramMode{ "Histogram Mode" };
 
     juce::ToggleButton enableHold{ "Enable Hold" };
     juce::TextButton resetHold{ "Reset Hold" };
@@ -299,5 +459,14 @@ private:
     juce::Slider goniometerScale{ juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,
                                   juce::Slider::TextEntryBoxPosition::TextBoxBelow };
 
+    // after the controls, so they are detached before the controls go
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+
+    std::unique_ptr<SliderAttachment> rmsThresholdAttachment, peakThresholdAttachment;
+    std::unique_ptr<ComboBoxAttachment> holdDurationAttachment, decayRateAttachment, avgDurationAttachment;
+    std::unique_ptr<ButtonAttachment> enableHoldAttachment;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PFMCPP_Project10AudioProcessorEditor)
 };
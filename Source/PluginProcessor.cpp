@@ -9,6 +9,39 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    template<typename ValueType>
+    struct Choice
+    {
+        const char* text;
+        ValueType value;
+    };
+
+    // each choice parameter's texts next to the values they stand for
+    const std::array<Choice<int>, 6> holdTimes{ { { "0.0s", 0 }, { "0.5s", 500 }, { "2.0s", 2000 }, { "4.0s", 4000 },
+                                                  { "6.0s", 6000 }, { "inf", std::numeric_limits<int>::max() } } };
+    const std::array<Choice<float>, 5> decayRates{ { { "-3.0dB/s", 3.0f }, { "-6.0dB/s", 6.0f }, { "-12.0dB/s", 12.0f },
+                                                     { "-24.0dB/s", 24.0f }, { "-36.0dB/s", 36.0f } } };
+    // RMS time constants in seconds, 0 stands for VU ballistics
+    const std::array<Choice<float>, 6> averageTimes{ { { "100ms", 0.10f }, { "250ms", 0.25f }, { "500ms", 0.50f },
+                                                       { "1000ms", 1.0f }, { "2000ms", 2.0f }, { "VU", 0.0f } } };
+
+    template<typename ValueType, size_t Size>
+    juce::StringArray getTexts(const std::array<Choice<ValueType>, Size>& choices)
+    {
+        juce::StringArray texts;
+        for (auto& choice : choices)
+            texts.add(choice.text);
+        return texts;
+    }
+
+    template<typename ValueType, size_t Size>
+    ValueType getValue(const std::array<Choice<ValueType>, Size>& choices, int index)
+    {
+        return choices[static_cast<size_t>(juce::jlimit(0, static_cast<int>(Size) - 1, index))].value;
+    }
+}
 //==============================================================================
 PFMCPP_Project10AudioProcessor::PFMCPP_Project10AudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -22,21 +55,66 @@ PFMCPP_Project10AudioProcessor::PFMCPP_Project10AudioProcessor()
                        )
 #endif
 {
-    valueTree.setProperty(juce::Identifier("Decay Time"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("Average Time"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("Meter View Mode"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("Goniometer Scale"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("Enable Hold"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("Hold Time"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("Histogram View"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("Peak Threshold"), 1, nullptr);
-    valueTree.setProperty(juce::Identifier("RMS Threshold"), 1, nullptr);
+    addViewDefaults(apvts.state);
+
+    averageTime = apvts.getRawParameterValue("averageTime");
 }
 
 PFMCPP_Project10AudioProcessor::~PFMCPP_Project10AudioProcessor()
 {
 }
 
+void PFMCPP_Project10AudioProcessor::addViewDefaults(juce::ValueTree& state)
+{
+    auto addDefault = [&state](const char* name, const juce::var& value)
+    {
+        if (!state.hasProperty(juce::Identifier(name)))
+            state.setProperty(juce::Identifier(name), value, nullptr);
+    };
+
+    // combo box ids start at 1
+    addDefault("Meter View Mode", 3);
+    addDefault("Goniometer Scale", 1.0f);
+    addDefault("Histogram View", 1);
+    addDefault("Histogram Mode", 1);
+}
+
+//==============================================================================
+juce::AudioProcessorValueTreeState::ParameterLayout PFMCPP_Project10AudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    juce::NormalisableRange<float> thresholdRange(NEGATIVE_INFINITY, MAX_DECIBELS, 0.1f);
+    layout.add(std::make_unique<juce::AudioParameterFloat>("peakThreshold", "Peak Threshold", thresholdRange, 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("rmsThreshold", "RMS Threshold", thresholdRange, 0.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("holdTime", "Hold Time", getTexts(holdTimes), 1));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("decayRate", "Decay Rate", getTexts(decayRates), 1));
+    // RMS time constants, or VU ballistics; the PEAK bars always follow the PPM
+    layout.add(std::make_unique<juce::AudioParameterChoice>("averageTime", "Average Time", getTexts(averageTimes), 2));
+    layout.add(std::make_unique<juce::AudioParameterBool>("enableHold", "Enable Hold", true));
+
+    return layout;
+}
+
+int PFMCPP_Project10AudioProcessor::getHoldTimeMs(int choiceIndex) { return getValue(holdTimes, choiceIndex); }
+
+float PFMCPP_Project10AudioProcessor::getDecayRateDbPerSecond(int choiceIndex) { return getValue(decayRates, choiceIndex); }
+
+void PFMCPP_Project10AudioProcessor::applyAverageTime()
+{
+    auto index = juce::roundToInt(averageTime->load());
+    if (index == appliedAverageTime)
+        return;
+
+    auto rmsTime = getValue(averageTimes, index);
+    if (rmsTime > 0.0f)
+        meterEngine.setAverageBallistics(MeterBallistics::AverageMode::Rms, rmsTime);
+    else
+        meterEngine.setAverageBallistics(MeterBallistics::AverageMode::Vu, 0.0f);
+
+    appliedAverageTime = index;
+}
 //==============================================================================
 const juce::String PFMCPP_Project10AudioProcessor::getName() const
 {
@@ -104,7 +182,12 @@ void PFMCPP_Project10AudioProcessor::prepareToPlay (double sampleRate, int sampl
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    audioBufferFifo.prepare(samplesPerBlock, getNumInputChannels());
+    auto pausedAnalysis = analyser.pauseAnalysis();
+    audioBufferFifo.prepare(getTotalNumInputChannels(), sampleRate, SAMPLE_FIFO_CAPACITY_MS);
+    loudnessEngine.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+    appliedAverageTime = -1;
+    applyAverageTime();
+    meterEngine.prepare(sampleRate);
 
 
 
@@ -146,12 +229,10 @@ bool PFMCPP_Project10AudioProcessor::isBusesLayoutSupported (const BusesLayout&
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to 7.1.4 can be metered, every channel gets
+    // its own meter column.
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels < 1 || numChannels > MAX_CHANNELS)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -168,6 +249,7 @@ bool PFMCPP_Project10AudioProcessor::isBusesLayoutSupported (const BusesLayout&
 void PFMCPP_Project10AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    RealtimeDiagnostics::ScopedBlock scopedBlock(diagnostics, buffer.getNumSamples(), getSampleRate());
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -198,7 +280,15 @@ void PFMCPP_Project10AudioProcessor::processBlock (juce::AudioBuffer<float>& buf
         gain.process(gainProcessContext);
         panner.process(gainProcessContext);
     #endif
-    audioBufferFifo.push(buffer);
+    applyAverageTime();
+    auto record = meterEngine.process(buffer);
+    loudnessEngine.process(buffer);
+    record.loudness = loudnessEngine.getValues();
+
+    if (!meterRecordFifo.push(record))
+        diagnostics.countRecordOverrun();
+    if (!audioBufferFifo.push(buffer))
+        diagnostics.countSampleOverrun();
     //buffer.clear();
 
     // In case we have more outputs than inputs, this code clears any output
@@ -242,26 +332,24 @@ void PFMCPP_Project10AudioProcessor::getStateInformation (juce::MemoryBlock& des
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
-    if (valueTree.isValid())
-    {
-        juce::MemoryOutputStream mos(destData, false);
-        valueTree.writeToStream(mos);
-    }
+    juce::MemoryOutputStream mos(destData, false);
+    apvts.copyState().writeToStream(mos);
 }
 
 void PFMCPP_Project10AudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
-    juce::MemoryBlock mb(data, sizeInBytes);
-    juce::MemoryInputStream mis(mb, false);
-    juce::ValueTree loadTree = juce::ValueTree::readFromStream(mis);
+    juce::MemoryInputStream mis(data, static_cast<size_t>(sizeInBytes), false);
+    auto loadTree = juce::ValueTree::readFromStream(mis);
 
-    if (valueTree.isValid() && valueTree.isEquivalentTo(loadTree))
-    {
-        valueTree = loadTree;
+    if (!loadTree.hasType(apvts.state.getType()))
+        return;
 
-    }
+    // replaceState() rebinds every parameter and recreates the children an older
+    // state lacks; an open editor rebinds its view values when the state is redirected
+    addViewDefaults(loadTree);
+    apvts.replaceState(loadTree);
 }
 
 //==============================================================================
@@ -9,170 +9,11 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "RealtimeDiagnostics.h"
+#include "MeterAnalyser.h"
 
 #define OSC_GAIN false
-//==============================================================================
-/**
-*/
-template<typename T>
-struct Averager
-{
-    Averager(size_t numElements, T initialValue)
-    {
-        resize(numElements, initialValue);
-    }
-
-    void resize(size_t numElements, T initialValue)
-    {
-        elements.resize(numElements);
-        clear(initialValue);
-    }
-
-    void clear(T initialValue)
-    {
-        for (auto& element : elements)
-        {
-            element = initialValue;
-        }
-        
-        writeIndex = 0;
-        sum = initialValue * elements.size();
-        avg = static_cast<float>(initialValue);
-    }
-
-    size_t getSize() const { return elements.size(); }
-
-    void add(T t)
-    {
-        auto currentSum = sum.load();
-        auto currentIndex = writeIndex.load();
-        auto currentAvg = avg.load();
-
-        currentSum = currentSum - elements[currentIndex] + t;
-        currentAvg = static_cast<float>(currentSum / elements.size());
-        elements[currentIndex] = t;
-        ++currentIndex;
-        if (currentIndex == elements.size())
-            currentIndex = 0;
-
-        sum.store(currentSum);
-        writeIndex.store(currentIndex);
-        avg.store(currentAvg);
-    }
-
-    float getAvg() const { return avg; }
-
-private:
-    std::vector<T> elements;
-    std::atomic<float> avg{ static_cast<float>(T()) };
-    std::atomic<size_t> writeIndex = 0;
-    std::atomic<T> sum{ 0 };
-};
-//==============================================================================
-template<typename T, size_t Size>
-struct Fifo
-{
-    size_t getSize() const noexcept
-    {
-        return Size;
-    }
-
-    void prepare(int numSamples, int numChannels)
-    {
-        for (auto& bufferCell : buffer)
-        {
-            // setSize() and clear() are taken from AudioBuffer<Type> class
-            bufferCell.setSize(numChannels,
-                       numSamples,
-                       false,
-                       true,
-                       false);
-
-            bufferCell.clear();
-        }
-    }
-
-    bool push(const T& t)
-    {
-        auto write = fifo.write(1);
-        if (write.blockSize1 > 0)
-        {
-            buffer[write.startIndex1] = t;
-            return true;
-        }
-        return false;
-    }
-    bool pull(T& t)
-    {   
-        auto read = fifo.read(1);
-        if (read.blockSize1 > 0)
-        {
-            t = buffer[read.startIndex1];
-            return true;
-        }
-        return false;
-    }
-
-    int getNumAvailableForReading() const
-    {
-        return fifo.getNumReady();
-    }
-    int getAvailableSpace() const
-    {
-        return fifo.getFreeSpace();
-    }
-
-private:
-    juce::AbstractFifo fifo{ Size };
-    std::array<T, Size> buffer;
-};
-
-//==============================================================================
-template<typename T>
-struct ReadAllAfterWriteCircularBuffer
-{
-    using DataType = std::vector<T>;
-    ReadAllAfterWriteCircularBuffer(T fillValue) { data.resize(1, fillValue); }
-
-    void resize(std::size_t s, T fillValue)
-    {
-        data.resize(s, fillValue);
-        resetWriteIndex();
-    }
-
-    void clear(T fillValue)
-    {
-        for (int i = 0; i < data.size(); ++i)
-        {
-            data[i] = fillValue;
-        }
-
-        resetWriteIndex();
-    }
-    void write(T t)
-    {
-        auto index = writeIndex.load();
-        data[index] = t;
-        ++index;
-        if (index == data.size())
-        {
-            index = 0;
-        }
-        writeIndex.store(index);
-    }
-
-    DataType& getData() { return data; }
-
-    size_t getReadIndex() const { return writeIndex.load(); }
-
-    size_t getSize() const { return data.size(); }
-
-private:
-    void resetWriteIndex() { writeIndex.store(0); }
-
-    std::atomic<std::size_t> writeIndex{ 0 };
-    DataType data;
-};
+#define SAMPLE_FIFO_CAPACITY_MS 200.0
 //==============================================================================
 class PFMCPP_Project10AudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
@@ -217,10 +58,34 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    Fifo<juce::AudioBuffer<float>, 32> audioBufferFifo;
-    juce::ValueTree valueTree{ "Value Tree" };
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    /** What the holdTime choices stand for, std::numeric_limits<int>::max() holds forever. */
+    static int getHoldTimeMs(int choiceIndex);
+    /** What the decayRate choices stand for. */
+    static float getDecayRateDbPerSecond(int choiceIndex);
+
+    SampleFifo<float> audioBufferFifo;
+    Fifo<MeterRecord, 512> meterRecordFifo;
+    // the metering settings are parameters, the view settings plain properties of state
+    juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
+    RealtimeDiagnostics diagnostics;
+    MeterAnalyser analyser{ *this, meterRecordFifo, audioBufferFifo };
+
+    /** Restarts integrated loudness and loudness range on the next block. */
+    void resetLoudness() { loudnessEngine.requestReset(); }
 
 private:
+    MeterEngine meterEngine;
+    LoudnessEngine loudnessEngine;
+
+    // read lock-free by processBlock
+    std::atomic<float>* averageTime{ nullptr };
+    int appliedAverageTime{ -1 };
+
+    void applyAverageTime();
+    /** Adds the view properties state is missing, e.g. one saved by an older version. */
+    static void addViewDefaults(juce::ValueTree& state);
+
     #if OSC_GAIN
         juce::dsp::Oscillator<float> osc;
         juce::dsp::Oscillator<float> osc2;
@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+
+    RealtimeDiagnostics.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeDiagnostics.h"
+
+#if RT_SAFETY_CHECKS
+ #if JUCE_WINDOWS
+  #ifndef NOMINMAX
+   #define NOMINMAX
+  #endif
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+  #include <intrin.h>
+ #else
+  #include <time.h>
+ #endif
+
+ #include <cstdlib>
+ #include <new>
+
+namespace
+{
+    // set while the audio thread is inside processBlock
+    thread_local RealtimeDiagnostics* activeDiagnostics = nullptr;
+
+    // CPU time the calling thread actually ran and the wall clock, both in
+    // nanoseconds; the difference over a block is time spent waiting
+   #if JUCE_WINDOWS
+    // thread cycle time is counted in TSC ticks, so both come from the TSC
+    double nanosPerTick = 1000.0 / juce::jmax(1, juce::SystemStats::getCpuSpeedInMegahertz());
+
+    juce::int64 getThreadNanos()
+    {
+        ULONG64 cycles = 0;
+        QueryThreadCycleTime(GetCurrentThread(), &cycles);
+        return static_cast<juce::int64>(cycles * nanosPerTick);
+    }
+
+    juce::int64 getWallNanos() { return static_cast<juce::int64>(__rdtsc() * nanosPerTick); }
+   #else
+    juce::int64 readClock(clockid_t clock)
+    {
+        timespec time;
+        clock_gettime(clock, &time);
+        return static_cast<juce::int64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    juce::int64 getThreadNanos() { return readClock(CLOCK_THREAD_CPUTIME_ID); }
+    juce::int64 getWallNanos() { return readClock(CLOCK_MONOTONIC); }
+   #endif
+
+    void* allocate(std::size_t size)
+    {
+        if (auto* diagnostics = activeDiagnostics)
+            diagnostics->countHeapOperation();
+
+        if (auto* pointer = std::malloc(size == 0 ? 1 : size))
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+
+    void release(void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+
+        if (auto* diagnostics = activeDiagnostics)
+            diagnostics->countHeapOperation();
+
+        std::free(pointer);
+    }
+
+   #if __cpp_aligned_new
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        if (auto* diagnostics = activeDiagnostics)
+            diagnostics->countHeapOperation();
+
+        auto align = static_cast<std::size_t>(alignment);
+        size = size == 0 ? align : (size + align - 1) / align * align;
+
+       #if JUCE_WINDOWS
+        if (auto* pointer = _aligned_malloc(size, align))
+       #else
+        if (auto* pointer = std::aligned_alloc(align, size))
+       #endif
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+
+    void releaseAligned(void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+
+        if (auto* diagnostics = activeDiagnostics)
+            diagnostics->countHeapOperation();
+
+       #if JUCE_WINDOWS
+        _aligned_free(pointer);
+       #else
+        std::free(pointer);
+       #endif
+    }
+   #endif
+
+    template<typename T>
+    void storeMax(std::atomic<T>& target, T value)
+    {
+        auto current = target.load(std::memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+}
+
+// replaced for the whole plugin binary, they only count while a ScopedBlock is active
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+
+ #if __cpp_aligned_new
+// over-aligned types (alignas > __STDCPP_DEFAULT_NEW_ALIGNMENT__) come through here
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+void operator delete(void* pointer, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(pointer); }
+ #endif
+#endif
+//==============================================================================
+RealtimeDiagnostics::ScopedBlock::ScopedBlock(RealtimeDiagnostics& owner, int numSamples, double sampleRate)
+    : diagnostics(owner)
+{
+    if (diagnostics.resetRequested.exchange(false))
+        diagnostics.reset();
+
+    diagnostics.numBlocks.fetch_add(1, std::memory_order_relaxed);
+
+   #if RT_SAFETY_CHECKS
+    deadlineSeconds = sampleRate > 0.0 ? numSamples / sampleRate : 0.0;
+    previouslyActive = activeDiagnostics;
+    activeDiagnostics = &diagnostics;
+
+    startThreadNanos = getThreadNanos();
+    startWallNanos = getWallNanos();
+    startTicks = juce::Time::getHighResolutionTicks();
+   #else
+    juce::ignoreUnused(numSamples, sampleRate);
+   #endif
+}
+
+RealtimeDiagnostics::ScopedBlock::~ScopedBlock()
+{
+   #if RT_SAFETY_CHECKS
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    auto waitedNanos = (getWallNanos() - startWallNanos) - (getThreadNanos() - startThreadNanos);
+    activeDiagnostics = previouslyActive;
+
+    if (deadlineSeconds <= 0.0)
+        return;
+
+    auto load = static_cast<float>(100.0 * seconds / deadlineSeconds);
+    auto bin = juce::jlimit(0, numLoadBins - 1, static_cast<int>(load));
+    diagnostics.loadBins[bin].fetch_add(1, std::memory_order_relaxed);
+    storeMax(diagnostics.worstLoad, load);
+    storeMax(diagnostics.worstMicros, seconds * 1.0e6);
+
+    // a lock, a page fault or the scheduler took the thread away for more
+    // than a tenth of the deadline
+    auto waitedMicros = waitedNanos / 1000.0;
+    if (waitedMicros > deadlineSeconds * 1.0e5)
+    {
+        diagnostics.stalls.fetch_add(1, std::memory_order_relaxed);
+        storeMax(diagnostics.worstStallMicros, waitedMicros);
+    }
+   #endif
+}
+//==============================================================================
+RealtimeDiagnostics::Snapshot RealtimeDiagnostics::getSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.checksEnabled = RT_SAFETY_CHECKS;
+    snapshot.numBlocks = numBlocks.load();
+    snapshot.recordOverruns = recordOverruns.load();
+    snapshot.sampleOverruns = sampleOverruns.load();
+    snapshot.underruns = underruns.load();
+    snapshot.heapOperations = heapOperations.load();
+    snapshot.stalls = stalls.load();
+    snapshot.worstStallMicros = worstStallMicros.load();
+    snapshot.worstLoad = worstLoad.load();
+    snapshot.worstMicros = worstMicros.load();
+
+    std::array<juce::uint32, numLoadBins> counts;
+    juce::uint64 total = 0;
+    for (int bin = 0; bin < numLoadBins; ++bin)
+    {
+        counts[bin] = loadBins[bin].load(std::memory_order_relaxed);
+        total += counts[bin];
+    }
+
+    if (total == 0)
+        return snapshot;
+
+    auto percentile = [&](double fraction)
+    {
+        auto target = fraction * total;
+        juce::uint64 cumulative = 0;
+        for (int bin = 0; bin < numLoadBins; ++bin)
+        {
+            cumulative += counts[bin];
+            if (cumulative >= target)
+                return static_cast<float>(bin + 1);     // upper edge of the bin
+        }
+        return static_cast<float>(numLoadBins);
+    };
+
+    snapshot.loadP50 = percentile(0.5);
+    snapshot.loadP95 = percentile(0.95);
+    snapshot.loadP99 = percentile(0.99);
+    snapshot.loadP999 = percentile(0.999);
+    return snapshot;
+}
+
+juce::String RealtimeDiagnostics::dump() const
+{
+    auto snapshot = getSnapshot();
+    juce::StringArray lines;
+
+    lines.add("blocks: " + juce::String(snapshot.numBlocks));
+    lines.add("meter record overruns: " + juce::String(snapshot.recordOverruns));
+    lines.add("sample fifo overruns: " + juce::String(snapshot.sampleOverruns));
+    lines.add("analysis underruns: " + juce::String(snapshot.underruns));
+
+    if (!snapshot.checksEnabled)
+    {
+        lines.add("heap, stall and timing checks disabled (RT_SAFETY_CHECKS)");
+        return lines.joinIntoString("\n");
+    }
+
+    lines.add("heap operations in processBlock: " + juce::String(snapshot.heapOperations));
+    lines.add("stalls: " + juce::String(snapshot.stalls) + ", worst " + juce::String(snapshot.worstStallMicros, 1) + " us");
+    lines.add("load p50/p95/p99/p99.9: " + juce::String(snapshot.loadP50, 0) + "% / " + juce::String(snapshot.loadP95, 0) + "% / "
+              + juce::String(snapshot.loadP99, 0) + "% / " + juce::String(snapshot.loadP999, 0) + "% of deadline");
+    lines.add("worst: " + juce::String(snapshot.worstMicros, 1) + " us, " + juce::String(snapshot.worstLoad, 1) + "% of deadline");
+
+    return lines.joinIntoString("\n");
+}
+
+void RealtimeDiagnostics::reset()
+{
+    numBlocks = 0;
+    recordOverruns = 0;
+    sampleOverruns = 0;
+    underruns = 0;
+    heapOperations = 0;
+    stalls = 0;
+    worstStallMicros = 0.0;
+
+    for (auto& bin : loadBins)
+        bin = 0;
+
+    worstLoad = 0.0f;
+    worstMicros = 0.0;
+}
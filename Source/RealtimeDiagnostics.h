@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    RealtimeDiagnostics.h
+    Evidence about the audio thread: FIFO overruns and underruns, heap use
+    and stalls inside processBlock, and processBlock durations against the
+    block deadline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// heap tracking, stall detection and timing; the FIFO counters are always on
+#ifndef RT_SAFETY_CHECKS
+ #define RT_SAFETY_CHECKS JUCE_DEBUG
+#endif
+//==============================================================================
+struct RealtimeDiagnostics
+{
+    struct Snapshot
+    {
+        bool checksEnabled{ false };
+        juce::int64 numBlocks{ 0 };
+
+        int recordOverruns{ 0 };        // meter records dropped, Fifo full
+        int sampleOverruns{ 0 };        // blocks missing from the SampleFifo
+        int underruns{ 0 };             // editor frames in which audio waited for an overdue analysis pass
+
+        juce::int64 heapOperations{ 0 };    // new/delete inside processBlock
+        int stalls{ 0 };                    // blocks in which the thread waited
+        double worstStallMicros{ 0.0 };
+
+        // processBlock duration as a percentage of the block's duration
+        float loadP50{ 0.0f }, loadP95{ 0.0f }, loadP99{ 0.0f }, loadP999{ 0.0f };
+        float worstLoad{ 0.0f };
+        double worstMicros{ 0.0 };
+    };
+
+    /** Instruments one processBlock call on the stack of the audio thread. */
+    struct ScopedBlock
+    {
+        ScopedBlock(RealtimeDiagnostics& owner, int numSamples, double sampleRate);
+        ~ScopedBlock();
+
+    private:
+        RealtimeDiagnostics& diagnostics;
+       #if RT_SAFETY_CHECKS
+        double deadlineSeconds;
+        juce::int64 startTicks;
+        juce::int64 startThreadNanos, startWallNanos;
+        RealtimeDiagnostics* previouslyActive;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    void countRecordOverrun() { recordOverruns.fetch_add(1, std::memory_order_relaxed); }
+    void countSampleOverrun() { sampleOverruns.fetch_add(1, std::memory_order_relaxed); }
+    void countUnderrun() { underruns.fetch_add(1, std::memory_order_relaxed); }
+    void countHeapOperation() { heapOperations.fetch_add(1, std::memory_order_relaxed); }
+
+    juce::int64 getNumBlocks() const { return numBlocks.load(std::memory_order_relaxed); }
+
+    /** Any thread. Percentiles are resolved to 1% of the deadline. */
+    Snapshot getSnapshot() const;
+    /** Multi-line report of the snapshot, for logs and bug reports. */
+    juce::String dump() const;
+    /** Any thread, applied at the start of the next block. */
+    void requestReset() { resetRequested = true; }
+
+private:
+    static constexpr int numLoadBins = 256;     // 1% each, the last one collects everything slower
+
+    std::atomic<juce::int64> numBlocks{ 0 };
+    std::atomic<int> recordOverruns{ 0 }, sampleOverruns{ 0 }, underruns{ 0 };
+    std::atomic<juce::int64> heapOperations{ 0 };
+    std::atomic<int> stalls{ 0 };
+    std::atomic<double> worstStallMicros{ 0.0 };
+
+    std::array<std::atomic<juce::uint32>, numLoadBins> loadBins{};
+    std::atomic<float> worstLoad{ 0.0f };
+    std::atomic<double> worstMicros{ 0.0 };
+
+    std::atomic<bool> resetRequested{ false };
+
+    void reset();
+};